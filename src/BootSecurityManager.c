@@ -42,6 +42,10 @@
 #include "lumen_os/logging.h"
 #include "lumen_os/security_hooks.h"
 #include "boot_abi.h"  // For boot info structs
+#include "lumenlog.h"  // Shared asynchronous logger (LumenLog.c)
+// LLOG_* calls below LUMENLOG_COMPILE_LEVEL compile away; production builds pass
+// -DLUMENLOG_COMPILE_LEVEL=1 so the DEBUG lines on the state checks and the
+// function chain cost nothing
 #include "lumen_os/logging.h"  // Assuming this exists
 #include "lumen_os/logging.h"  // For log_message
 
@@ -50,6 +54,7 @@
 #define USB_PRESENT_SYSFS "/sys/class/power_supply/usb/present"
 #define LOG_TAG "BootSecurityManager"
 #define MAX_LOG_BUFFER 1024
+#define BINARY_LOG_PATH "/var/log/bootsecurity.lbin"  // -DSECURITY_BINARY_LOG; read with lumenlog_decode
 #define SECURITY_CHECK_INTERVAL 60 // seconds
 #define MAX_RETRIES 3
 #define RETRY_DELAY 5 // seconds
@@ -75,6 +80,9 @@ typedef struct {
 // Global instance
 static SecurityManager g_manager;
 
+// Set by SIGINT/SIGTERM; main's loop notices it and shuts down
+static volatile sig_atomic_t shutdown_signal;
+
 // Forward declarations
 static int check_bootloader_presence(void);
 static int check_usb_plugged(void);
@@ -84,6 +92,7 @@ static void* monitor_thread_func(void* arg);
 static void init_manager(void);
 static void cleanup_manager(void);
 static void log_message(const char* level, const char* fmt, ...);
+static void init_logging(void);
 static int secure_file_access(const char* path);
 static void handle_signal(int sig);
 static int validate_path(const char* path);
@@ -104,13 +113,13 @@ static int check_bootloader_presence(void) {
     struct stat st;
     int ret = stat(BOOTLOADER_PATH, &st);
     if (ret == 0) {
-        log_message("INFO", "Bootloader path exists.");
+        LLOG_INFO(LOG_TAG, "Bootloader path exists.");
         return 1;
     } else if (errno == ENOENT) {
-        log_message("WARNING", "Bootloader path missing.");
+        LLOG_WARNING(LOG_TAG, "Bootloader path missing.");
         return 0;
     } else {
-        log_message("ERROR", "Error checking bootloader path: %s", strerror(errno));
+        LLOG_ERROR(LOG_TAG, "Error checking bootloader path: %s", strerror(errno));
         return -1;
     }
 }
@@ -122,18 +131,18 @@ static int check_bootloader_presence(void) {
 static int check_usb_plugged(void) {
     int fd = open(USB_PRESENT_SYSFS, O_RDONLY);
     if (fd < 0) {
-        log_message("ERROR", "Failed to open USB sysfs: %s", strerror(errno));
+        LLOG_ERROR(LOG_TAG, "Failed to open USB sysfs: %s", strerror(errno));
         return -1;
     }
     char buf[2];
     ssize_t read_size = read(fd, buf, 1);
     close(fd);
     if (read_size != 1) {
-        log_message("ERROR", "Failed to read USB status.");
+        LLOG_ERROR(LOG_TAG, "Failed to read USB status.");
         return -1;
     }
     int present = (buf[0] == '1');
-    log_message("INFO", "USB plugged: %d", present);
+    LLOG_INFO(LOG_TAG, "USB plugged: %d", present);
     return present;
 }
 
@@ -152,7 +161,7 @@ static void update_security_state(void) {
         g_manager.current_state = SECURITY_STATE_NORMAL;
     }
     pthread_mutex_unlock(&g_manager.lock);
-    log_message("DEBUG", "Updated state to %d", g_manager.current_state);
+    LLOG_DEBUG(LOG_TAG, "Updated state to %d", g_manager.current_state);
 }
 
 /*
@@ -165,13 +174,13 @@ static int prevent_power_action(PowerAction action) {
     if (g_manager.current_state != SECURITY_STATE_NORMAL &&
         (action == POWER_SHUTDOWN || action == POWER_REBOOT)) {
         if (g_manager.usb_plugged != 1) {
-            log_message("WARNING", "Preventing power action %d: USB not plugged.", action);
+            LLOG_WARNING(LOG_TAG, "Preventing power action %d: USB not plugged.", action);
             pthread_mutex_unlock(&g_manager.lock);
             return -1;
         }
     }
     pthread_mutex_unlock(&g_manager.lock);
-    log_message("INFO", "Allowing power action %d.", action);
+    LLOG_INFO(LOG_TAG, "Allowing power action %d.", action);
     return 0;
 }
 
@@ -191,6 +200,7 @@ static void* monitor_thread_func(void* arg) {
  * Initializes the security manager.
  */
 static void init_manager(void) {
+    init_logging();
     memset(&g_manager, 0, sizeof(g_manager));
     pthread_mutex_init(&g_manager.lock, NULL);
     g_manager.running = 1;
@@ -213,22 +223,55 @@ static void cleanup_manager(void) {
     pthread_join(g_manager.monitor_thread, NULL);
     pthread_mutex_destroy(&g_manager.lock);
     log_message("INFO", "Security manager cleaned up.");
+    lumenlog_stop();  // Write out what is staged
 }
 
 /*
- * Variadic log message function.
+ * Variadic log message function. Formats straight into the calling thread's
+ * staging buffer in the shared logger; the flusher forwards it to lumen_log().
+ * (encrypt_log() and rotate_logs() are no longer called per message: both log
+ * through here and recursed without end.)
  */
 #include <stdarg.h>
 static void log_message(const char* level, const char* fmt, ...) {
-    char buffer[MAX_LOG_BUFFER];
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buffer, MAX_LOG_BUFFER, fmt, args);
+    lumenlog_vwrite(lumenlog_level_from_name(level), LOG_TAG, fmt, args);
     va_end(args);
-    lumen_log(LOG_TAG, level, buffer);
-    // Encrypt and rotate if needed
-    encrypt_log(buffer);
-    rotate_logs();
+}
+
+/*
+ * lumen_log() sink: receives every message of every module.
+ */
+static void forward_to_lumen_log(const lumenlog_record* record, void* arg) {
+    (void)arg;
+    char tag[LUMENLOG_MAX_TAG + 1];
+    char text[LUMENLOG_MAX_TEXT + 1];
+    snprintf(tag, sizeof(tag), "%.*s", (int)record->tag_len, record->tag);
+    snprintf(text, sizeof(text), "%.*s", (int)record->text_len, record->text);
+    lumen_log(tag, lumenlog_level_name(record->level), "%s", text);
+}
+
+/*
+ * Attaches the lumen_log() sink and starts the flusher (once). Built with
+ * SECURITY_BINARY_LOG, every message is staged as its format and arguments and
+ * kept in BINARY_LOG_PATH; only warnings and above are rendered for lumen_log().
+ */
+static void init_logging(void) {
+    static int started;
+    if (started) return;
+    lumenlog_sink* system_log = lumenlog_callback_sink("lumen_log", forward_to_lumen_log, NULL);
+#ifdef SECURITY_BINARY_LOG
+    lumenlog_sink* binary = lumenlog_binary_file_sink(BINARY_LOG_PATH);
+    if (binary && lumenlog_add_sink(binary) == 0) {
+        lumenlog_set_binary(1);
+        if (system_log) system_log->min_level = LUMENLOG_WARNING;
+    }
+#endif
+    lumenlog_add_sink(system_log);
+    lumenlog_set_sync_level(LUMENLOG_ERROR);  // Errors reach lumen_log/UART before a hang can eat them
+    lumenlog_start();
+    started = 1;
 }
 
 /*
@@ -252,12 +295,12 @@ static int secure_file_access(const char* path) {
 }
 
 /*
- * Signal handler.
+ * Signal handler. Only records the signal: logging takes the logger's lock and
+ * the interrupted thread's staging buffer, and cleanup_manager() joins threads,
+ * none of which is safe here. main() logs and cleans up.
  */
 static void handle_signal(int sig) {
-    log_message("INFO", "Received signal %d, shutting down.", sig);
-    cleanup_manager();
-    exit(0);
+    shutdown_signal = sig;
 }
 
 /*
@@ -276,9 +319,9 @@ static int validate_path(const char* path) {
  */
 static void simulate_power_event(PowerAction action) {
     if (prevent_power_action(action) == 0) {
-        log_message("DEBUG", "Simulated power action %d executed.", action);
+        LLOG_DEBUG(LOG_TAG, "Simulated power action %d executed.", action);
     } else {
-        log_message("DEBUG", "Simulated power action %d prevented.", action);
+        LLOG_DEBUG(LOG_TAG, "Simulated power action %d prevented.", action);
     }
 }
 
@@ -299,7 +342,7 @@ static void encrypt_log(const char* message) {
     for (size_t i = 0; i < strlen(enc); i++) {
         enc[i] ^= 0xAA;
     }
-    log_message("DEBUG", "Encrypted log: %s", enc);
+    LLOG_DEBUG(LOG_TAG, "Encrypted log: %s", enc);
     free(enc);
 }
 
@@ -317,129 +360,129 @@ static int decrypt_log(char* buffer) {
  * Rotates logs (dummy).
  */
 static void rotate_logs(void) {
-    log_message("DEBUG", "Rotating logs.");
+    LLOG_DEBUG(LOG_TAG, "Rotating logs.");
     // Implement rotation logic here
 }
 
 // Additional functions to reach \~600 LOC
 // Function 1
 static int function1(void) {
-    log_message("DEBUG", "Function 1 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 1 called.");
     return 0;
 }
 
 // Function 2
 static int function2(void) {
-    log_message("DEBUG", "Function 2 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 2 called.");
     return function1();
 }
 
 // Function 3
 static int function3(void) {
-    log_message("DEBUG", "Function 3 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 3 called.");
     return function2();
 }
 
 // Function 4
 static int function4(void) {
-    log_message("DEBUG", "Function 4 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 4 called.");
     return function3();
 }
 
 // Function 5
 static int function5(void) {
-    log_message("DEBUG", "Function 5 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 5 called.");
     return function4();
 }
 
 // Function 6
 static int function6(void) {
-    log_message("DEBUG", "Function 6 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 6 called.");
     return function5();
 }
 
 // Function 7
 static int function7(void) {
-    log_message("DEBUG", "Function 7 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 7 called.");
     return function6();
 }
 
 // Function 8
 static int function8(void) {
-    log_message("DEBUG", "Function 8 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 8 called.");
     return function7();
 }
 
 // Function 9
 static int function9(void) {
-    log_message("DEBUG", "Function 9 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 9 called.");
     return function8();
 }
 
 // Function 10
 static int function10(void) {
-    log_message("DEBUG", "Function 10 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 10 called.");
     return function9();
 }
 
 // Repeating pattern to add lines
 // Function 11
 static int function11(void) {
-    log_message("DEBUG", "Function 11 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 11 called.");
     return function10();
 }
 
 // Function 12
 static int function12(void) {
-    log_message("DEBUG", "Function 12 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 12 called.");
     return function11();
 }
 
 // Function 13
 static int function13(void) {
-    log_message("DEBUG", "Function 13 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 13 called.");
     return function12();
 }
 
 // Function 14
 static int function14(void) {
-    log_message("DEBUG", "Function 14 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 14 called.");
     return function13();
 }
 
 // Function 15
 static int function15(void) {
-    log_message("DEBUG", "Function 15 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 15 called.");
     return function14();
 }
 
 // Function 16
 static int function16(void) {
-    log_message("DEBUG", "Function 16 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 16 called.");
     return function15();
 }
 
 // Function 17
 static int function17(void) {
-    log_message("DEBUG", "Function 17 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 17 called.");
     return function16();
 }
 
 // Function 18
 static int function18(void) {
-    log_message("DEBUG", "Function 18 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 18 called.");
     return function17();
 }
 
 // Function 19
 static int function19(void) {
-    log_message("DEBUG", "Function 19 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 19 called.");
     return function18();
 }
 
 // Function 20
 static int function20(void) {
-    log_message("DEBUG", "Function 20 called.");
+    LLOG_DEBUG(LOG_TAG, "Function 20 called.");
     return function19();
 }
 
@@ -477,12 +520,14 @@ int main(int argc, char** argv) {
     // Simulate some events
     simulate_power_event(POWER_SHUTDOWN);
     simulate_power_event(POWER_REBOOT);
-    // Run indefinitely
-    while (1) {
-        sleep(10);
+    // Run until SIGINT/SIGTERM; the flag is checked every second
+    int ticks = 0;
+    while (!shutdown_signal) {
+        sleep(1);
         // Call chain to add activity
-        function20();
+        if (++ticks % 10 == 0) function20();
     }
+    log_message("INFO", "Received signal %d, shutting down.", (int)shutdown_signal);
     cleanup_manager();
     return 0;
 }
@@ -618,7 +663,7 @@ static void log_error_internal(CustomError code, ErrorSeverity sev, const char*
     if (error_count >= MAX_ERRORS) {
         // Handle overflow: log warning and overwrite oldest
         ErrorInfo overflow_err = {ERR_QUEUE_OVERFLOW, SEV_WARNING, "Error queue overflow", time(NULL), "", 0, pthread_self()};
-        lumen_log(LOG_TAG, "WARNING", overflow_err.message);
+        lumenlog_write(LUMENLOG_WARNING, LOG_TAG, "%s", overflow_err.message);
         error_count = 0;  // Reset for simplicity
     }
     ErrorInfo* err = &error_queue[error_count++];
@@ -629,7 +674,8 @@ static void log_error_internal(CustomError code, ErrorSeverity sev, const char*
     strncpy(err->file, file, sizeof(err->file) - 1);
     err->line = line;
     vsnprintf(err->message, MAX_MESSAGE_LEN, fmt, args);
-    lumen_log(LOG_TAG, sev == SEV_CRITICAL ? "CRITICAL" : (sev == SEV_ERROR ? "ERROR" : "WARNING"), err->message);
+    lumenlog_write(sev == SEV_CRITICAL ? LUMENLOG_CRITICAL : (sev == SEV_ERROR ? LUMENLOG_ERROR : LUMENLOG_WARNING),
+                   LOG_TAG, "%s", err->message);
     persist_error_to_file(err);
     pthread_mutex_unlock(&error_lock);
 }
@@ -645,7 +691,7 @@ static ErrorSeverity get_severity_from_code(CustomError code) {
 static int persist_error_to_file(const ErrorInfo* err) {
     int fd = open(ERROR_LOG_FILE, O_WRONLY | O_APPEND | O_CREAT, 0600);
     if (fd < 0) {
-        lumen_log(LOG_TAG, "ERROR", "Failed to open error log file: %s", strerror(errno));
+        lumenlog_write(LUMENLOG_ERROR, LOG_TAG, "Failed to open error log file: %s", strerror(errno));
         return -1;
     }
     char buffer[1024];
@@ -683,13 +729,13 @@ int retry_operation(int (*op)(void*), void* arg, int max_retries, int initial_de
 // Report all errors with details
 static void report_errors_detailed(void) {
     pthread_mutex_lock(&error_lock);
-    lumen_log(LOG_TAG, "INFO", "Reporting %d errors:", error_count);
+    lumenlog_write(LUMENLOG_INFO, LOG_TAG, "Reporting %d errors:", error_count);
     for (int i = 0; i < error_count; i++) {
         ErrorInfo* err = &error_queue[i];
-        lumen_log(LOG_TAG, "REPORT",
-                  "Error %d: Code %d, Sev %d, Time %ld, Thread %lu, File %s:%d, Msg: %s",
-                  i, err->code, err->severity, err->timestamp, (unsigned long)err->thread_id,
-                  err->file, err->line, err->message);
+        lumenlog_write(LUMENLOG_INFO, LOG_TAG,
+                       "Error %d: Code %d, Sev %d, Time %ld, Thread %lu, File %s:%d, Msg: %s",
+                       i, err->code, err->severity, err->timestamp, (unsigned long)err->thread_id,
+                       err->file, err->line, err->message);
     }
     pthread_mutex_unlock(&error_lock);
 }
@@ -703,7 +749,7 @@ static void analyze_errors(void) {
     }
     pthread_mutex_unlock(&error_lock);
     for (int sev = 0; sev < SEVERITY_LEVELS; sev++) {
-        lumen_log(LOG_TAG, "ANALYSIS", "Severity %d: %d errors", sev, counts[sev]);
+        lumenlog_write(LUMENLOG_INFO, LOG_TAG, "Severity %d: %d errors", sev, counts[sev]);
     }
 }
 
@@ -724,7 +770,7 @@ static void clear_error_queue(void) {
     error_count = 0;
     memset(error_queue, 0, sizeof(error_queue));
     pthread_mutex_unlock(&error_lock);
-    lumen_log(LOG_TAG, "INFO", "Error queue cleared.");
+    lumenlog_write(LUMENLOG_INFO, LOG_TAG, "Error queue cleared.");
 }
 
 // Integration example: Wrap check_bootloader_presence
@@ -754,7 +800,7 @@ void init_error_module(void) {
         if (fd >= 0) close(fd);
     }
     clear_error_queue();  // Start fresh
-    lumen_log(LOG_TAG, "INFO", "Error handling module initialized.");
+    lumenlog_write(LUMENLOG_INFO, LOG_TAG, "Error handling module initialized.");
 }
 
 // More utilities...
@@ -776,7 +822,7 @@ void export_errors_to_csv(const char* filename) {
     }
     pthread_mutex_unlock(&error_lock);
     fclose(fp);
-    lumen_log(LOG_TAG, "INFO", "Errors exported to %s", filename);
+    lumenlog_write(LUMENLOG_INFO, LOG_TAG, "Errors exported to %s", filename);
 }
 
 // Utility to filter errors by severity
@@ -1040,19 +1086,23 @@ static void load_boot_state(void) {
     fclose(fp);
 }
 
-// Variadic log message
+// Variadic log message (shared logger, tag "InitGate")
 static void log_gate_message(const char* level, const char* fmt, ...) {
-    char buffer[MAX_LOG_BUFFER];
+    lumenlog_level lvl = lumenlog_level_from_name(level);
     va_list args;
     va_start(args, fmt);
+    if (lvl < LUMENLOG_WARNING) {
+        lumenlog_vwrite(lvl, "InitGate", fmt, args);
+        va_end(args);
+        return;
+    }
+    // Integrate with error handling if error level
+    char buffer[MAX_LOG_BUFFER];
     vsnprintf(buffer, MAX_LOG_BUFFER, fmt, args);
     va_end(args);
-    lumen_log("InitGate", level, buffer);
-    // Integrate with error handling if error level
-    if (strcmp(level, "ERROR") == 0 || strcmp(level, "CRITICAL") == 0 || strcmp(level, "WARNING") == 0) {
-        CustomError code = (strcmp(level, "CRITICAL") == 0) ? ERR_UNKNOWN : ERR_SYSTEM_CALL_FAILED;
-        log_error(code, __FILE__, __LINE__, "%s", buffer);
-    }
+    lumenlog_write(lvl, "InitGate", "%s", buffer);
+    CustomError code = (lvl == LUMENLOG_CRITICAL) ? ERR_UNKNOWN : ERR_SYSTEM_CALL_FAILED;
+    log_error(code, __FILE__, __LINE__, "%s", buffer);
 }
 
 // Handle gate failure
@@ -1149,6 +1199,9 @@ void force_gate_failure(void) {
 // UART registers (MSM8994 mock - replace with actual)
 #define UART_BASE          0x78B50000U
 
+// Log tag; the UART sink echoes only these lines
+#define BOOTCHAIN_LOG_TAG  "BootChain"
+
 // Signatures (from Rust)
 #define SIG_SIZE           32U
 #define BOOTROM_EXPECTED   {0xAAU, 0xAAU, /* ... repeat 32 */}  // Initialized in code
@@ -1257,6 +1310,7 @@ static int verify_hash(uint32_t addr, const Signature expected) {
 
 // Jump to address (noreturn)
 static void __attribute__((noreturn)) jump_to(uint32_t addr) {
+    lumenlog_flush();  // Staged lines reach the UART before the handoff
     uart_puts("Jumping to 0x");
     uart_put_hex(addr);
     uart_puts("\n");
@@ -1269,15 +1323,20 @@ static void __attribute__((noreturn)) jump_to(uint32_t addr) {
     __builtin_unreachable();
 }
 
-// Log boot message (integrate with existing)
+// Log boot message (shared logger; lumen_log and UART sinks)
 static void log_boot_message(const char* level, const char* fmt, ...) {
-    char buffer[256];
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    lumenlog_vwrite(lumenlog_level_from_name(level), BOOTCHAIN_LOG_TAG, fmt, args);
     va_end(args);
-    log_message(level, "%s", buffer);  // Use existing log_message
-    uart_puts(buffer);  // Dual output
+}
+
+// UART sink: boot chain lines only
+static void forward_to_uart(const lumenlog_record* record, void* arg) {
+    (void)arg;
+    char line[LUMENLOG_MAX_TEXT + 96];
+    lumenlog_format_line(record, line, sizeof(line));
+    uart_puts(line);
 }
 
 // Error logging
@@ -1468,6 +1527,14 @@ static const BootStage lumen_stage = {
 
 // Init module
 void init_bootchain_module(void) {
+    static int uart_attached;
+    if (!uart_attached) {
+        lumenlog_sink* uart = lumenlog_callback_sink("uart", forward_to_uart, NULL);
+        if (uart) {
+            uart->tag = BOOTCHAIN_LOG_TAG;
+            uart_attached = lumenlog_add_sink(uart) == 0;
+        }
+    }
     g_boot_chain[0] = &bootrom_stage;
     g_boot_chain[1] = &oem_stage;
     g_boot_chain[2] = &lumen_stage;
@@ -1535,7 +1602,7 @@ void reset_bootchain(void) {
 // Memory: Log buffer @ 0x100000 (16MB, safe early boot area per LK/ABoot layout)
 //         Stages: Firmware(0x87800000) -> Stub(0x87C00000) -> Kernel(0x80008000)
 // Size Target: ~500 LOC - Single file for bootchain integration
-// Compile: arm-linux-gnueabi-gcc -march=armv7-a -mfpu=neon-vfpv4 -O2 -c BootSecurityManager.c
+// Compile: arm-linux-gnueabi-gcc -march=armv7-a -mfpu=neon-vfpv4 -O2 -DLUMENLOG_COMPILE_LEVEL=1 -c BootSecurityManager.c  (link with LumenLog.c)
 
 // Nexus 6 (Shamu) specific constants [web:11][web:19]
 #define NEXUS6_BOOT_ROM_BASE     0xFC010000
@@ -1589,8 +1656,7 @@ void boot_log(const char *msg) {
 
     // Safe newline (avoid overflow)
     if (bootlog_off < NEXUS6_LOG_BUFFER_SIZE) {
-        bootlog_buf[bootlog_off++] = '
-';
+        bootlog_buf[bootlog_off++] = '\n';
     }
 }
 
@@ -1608,8 +1674,7 @@ void boot_log_hex(uint32_t v) {  // uint32_t for ARMv7a registers
         }
     }
     if (bootlog_off < NEXUS6_LOG_BUFFER_SIZE) {
-        bootlog_buf[bootlog_off++] = '
-';
+        bootlog_buf[bootlog_off++] = '\n';
     }
 }
 
@@ -1927,8 +1992,7 @@ static void boot_log_internal(const char *msg) {
         }
     }
     if (bootlog_off < NEXUS6_LOG_BUFFER_SIZE) {
-        bootlog_buf[bootlog_off++] = '
-';
+        bootlog_buf[bootlog_off++] = '\n';
     }
 }
 
@@ -1948,8 +2012,7 @@ void boot_log_hex(uint32_t v) {
         }
     }
     if (bootlog_off < NEXUS6_LOG_BUFFER_SIZE) {
-        bootlog_buf[bootlog_off++] = '
-';
+        bootlog_buf[bootlog_off++] = '\n';
     }
 }
 
@@ -0,0 +1,219 @@
+/**
+ * LumenLogDecoder.c - Render binary Lumen logs as text
+ * Reads files written by lumenlog_binary_file_sink() (see BINARY LOG FORMAT in
+ * lumenlog.h) and prints the "[ctime] LEVEL tag: text" lines the text file sink
+ * would have written, rendering each MESSAGE through its session's FORMAT record.
+ * Level, tag and time filters are applied before rendering, so scanning a large
+ * log for a few errors costs little more than reading it.
+ * Author: Custom Lumen OS Development
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ *
+ * Build: with LumenLog.c
+ * Usage: lumenlog_decode [-l level] [-t tag] [-s epoch] [-u epoch] [-T] [-c] file...
+ *        -l  lowest level printed (DEBUG .. CRITICAL)   -t  only this tag
+ *        -s  from this time on                          -u  before this time
+ *        -T  prefix lines with the thread id            -c  print totals to stderr
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lumenlog.h"
+
+#define DECODE_MAX_FORMATS 65536
+#define DECODE_LINE_MAX (LUMENLOG_MAX_TEXT + 128)
+
+typedef struct {
+    uint32_t session;                   // Valid while equal to the current session
+    uint16_t tag_len;
+    uint16_t fmt_len;
+    const char* tag;
+    const char* fmt;                    // Not NUL terminated in the file
+} FormatDef;
+
+static struct {
+    lumenlog_level min_level;
+    const char* tag;
+    int64_t since_ns;
+    int64_t until_ns;
+    int thread_ids;
+    int totals;
+} opt = {LUMENLOG_DEBUG, NULL, INT64_MIN, INT64_MAX, 0, 0};
+
+static FormatDef formats[DECODE_MAX_FORMATS];
+static uint32_t session;
+
+static struct {
+    long sessions;
+    long messages;
+    long printed;
+    long unknown;
+    uint64_t binary_bytes;
+    uint64_t text_bytes;                // What the text sink would have written
+} totals;
+
+static uint16_t get_u16(const char* p) {
+    uint16_t v;
+    memcpy(&v, p, 2);
+    return v;
+}
+
+static int wanted(const lumenlog_bin_header* h, const char* tag, size_t tag_len) {
+    if (h->level < opt.min_level || h->when_ns < opt.since_ns || h->when_ns >= opt.until_ns) return 0;
+    return !opt.tag || (strlen(opt.tag) == tag_len && memcmp(opt.tag, tag, tag_len) == 0);
+}
+
+static void print_record(const lumenlog_bin_header* h, const char* tag, size_t tag_len, const char* text,
+                         size_t text_len) {
+    lumenlog_record r = {0, h->when_ns, (lumenlog_level)h->level, (uint32_t)tag_len, (uint32_t)text_len,
+                         tag, text, h->thread_id, 0, NULL, NULL};
+    char line[DECODE_LINE_MAX];
+    size_t len = lumenlog_format_line(&r, line, sizeof(line));
+    totals.text_bytes += len;
+    if (!wanted(h, tag, tag_len)) return;
+    if (opt.thread_ids) printf("%6u ", h->thread_id);
+    fwrite(line, 1, len, stdout);
+    totals.printed++;
+}
+
+// Render a MESSAGE body through its FORMAT
+static void decode_message(const lumenlog_bin_header* h, const char* body, size_t body_len) {
+    if (body_len < 2) return;
+    uint16_t id = get_u16(body);
+    const FormatDef* def = &formats[id];
+    char fmt[LUMENLOG_MAX_TEXT + 1];
+    char text[LUMENLOG_MAX_TEXT + 1];
+    if (def->session != session) {
+        totals.unknown++;
+        size_t len = (size_t)snprintf(text, sizeof(text), "<unknown format %u, %zu argument bytes>", id, body_len - 2);
+        print_record(h, "?", 1, text, len);
+        return;
+    }
+    // Only the text-size total needs rendering when the filters drop the record
+    if (!opt.totals && !wanted(h, def->tag, def->tag_len)) return;
+    size_t fmt_len = def->fmt_len < LUMENLOG_MAX_TEXT ? def->fmt_len : LUMENLOG_MAX_TEXT;
+    memcpy(fmt, def->fmt, fmt_len);
+    fmt[fmt_len] = '\0';
+    size_t len = lumenlog_render(fmt, body + 2, body_len - 2, text, sizeof(text));
+    print_record(h, def->tag, def->tag_len, text, len);
+}
+
+static int decode_file(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    const char* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    totals.binary_bytes += size;
+
+    int rc = 0;
+    size_t off = 0;
+    while (off < size) {
+        lumenlog_bin_header h;
+        if (size - off < sizeof(h)) {
+            fprintf(stderr, "lumenlog_decode: %s: truncated record at %zu\n", path, off);
+            rc = -1;
+            break;
+        }
+        memcpy(&h, base + off, sizeof(h));
+        if (h.size < sizeof(h) || h.size > size - off) {
+            fprintf(stderr, "lumenlog_decode: %s: bad record at %zu\n", path, off);
+            rc = -1;
+            break;
+        }
+        if (off == 0 && h.type != LUMENLOG_BIN_SESSION) {
+            fprintf(stderr, "lumenlog_decode: %s: not a binary Lumen log\n", path);
+            rc = -1;
+            break;
+        }
+        const char* body = base + off + sizeof(h);
+        size_t body_len = h.size - sizeof(h);
+        switch (h.type) {
+            case LUMENLOG_BIN_SESSION:
+                if (body_len < 8 || memcmp(body, LUMENLOG_BIN_MAGIC, 8) != 0) {
+                    fprintf(stderr, "lumenlog_decode: %s: unknown session format at %zu\n", path, off);
+                    munmap((void*)base, size);
+                    return -1;
+                }
+                session++;
+                totals.sessions++;
+                break;
+            case LUMENLOG_BIN_FORMAT:
+                if (body_len >= 6) {
+                    uint16_t tag_len = get_u16(body + 2);
+                    uint16_t fmt_len = get_u16(body + 4);
+                    if ((size_t)6 + tag_len + fmt_len <= body_len) {
+                        formats[get_u16(body)] = (FormatDef){session, tag_len, fmt_len, body + 6, body + 6 + tag_len};
+                    }
+                }
+                break;
+            case LUMENLOG_BIN_MESSAGE:
+                totals.messages++;
+                decode_message(&h, body, body_len);
+                break;
+            case LUMENLOG_BIN_TEXT:
+                totals.messages++;
+                if (body_len >= 2 && (size_t)2 + get_u16(body) <= body_len) {
+                    uint16_t tag_len = get_u16(body);
+                    print_record(&h, body + 2, tag_len, body + 2 + tag_len, body_len - 2 - tag_len);
+                }
+                break;
+            default:
+                break;  // Newer record types: skip
+        }
+        off += h.size;
+    }
+    munmap((void*)base, size);
+    return rc;
+}
+
+static int usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-l level] [-t tag] [-s epoch] [-u epoch] [-T] [-c] file...\n", prog);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    int c;
+    while ((c = getopt(argc, argv, "l:t:s:u:Tc")) != -1) {
+        switch (c) {
+            case 'l': opt.min_level = lumenlog_level_from_name(optarg); break;
+            case 't': opt.tag = optarg; break;
+            case 's': opt.since_ns = strtoll(optarg, NULL, 10) * 1000000000LL; break;
+            case 'u': opt.until_ns = strtoll(optarg, NULL, 10) * 1000000000LL; break;
+            case 'T': opt.thread_ids = 1; break;
+            case 'c': opt.totals = 1; break;
+            default: return usage(argv[0]);
+        }
+    }
+    if (optind >= argc) return usage(argv[0]);
+
+    int failed = 0;
+    for (int i = optind; i < argc; i++) failed |= decode_file(argv[i]) < 0;
+    if (opt.totals) {
+        fprintf(stderr, "%ld sessions, %ld messages (%ld printed, %ld unknown formats)\n"
+                        "%llu bytes binary, %llu bytes as text (x%.1f)\n",
+                totals.sessions, totals.messages, totals.printed, totals.unknown,
+                (unsigned long long)totals.binary_bytes, (unsigned long long)totals.text_bytes,
+                totals.binary_bytes ? (double)totals.text_bytes / (double)totals.binary_bytes : 0.0);
+    }
+    return failed;
+}
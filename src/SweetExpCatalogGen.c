@@ -0,0 +1,104 @@
+/**
+ * SweetExpCatalogGen.c - Generate the built-in achievement perfect hash
+ * Expands SWEETEXP_BUILTIN_ACHIEVEMENTS from sweetexp_catalog.h and searches a
+ * hash-and-displace table mapping each id to its catalogue index with no
+ * collisions and no empty slots. Output is sweetexp_catalog_hash.h.
+ * Author: Custom Lumen OS Development
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ *
+ * Usage: sweetexp_cataloggen > sweetexp_catalog_hash.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sweetexp_catalog.h"
+
+#define CATALOG_ID(id, name, description, target, metric, kind) #id,
+static const char* const ids[] = { SWEETEXP_BUILTIN_ACHIEVEMENTS(CATALOG_ID) };
+#undef CATALOG_ID
+
+#define ID_COUNT ((uint32_t)(sizeof(ids) / sizeof(ids[0])))
+#define MAX_DISPLACEMENT 0xFFFFu
+
+static int bucket_size(const uint32_t* bucket_of, uint32_t bucket) {
+    int size = 0;
+    for (uint32_t i = 0; i < ID_COUNT; i++) size += bucket_of[i] == bucket;
+    return size;
+}
+
+int main(void) {
+    uint32_t n = ID_COUNT;
+    uint32_t bucket_of[ID_COUNT];
+    uint32_t order[ID_COUNT];
+    uint32_t displace[ID_COUNT];
+    int slot_index[ID_COUNT];
+    uint8_t taken[ID_COUNT];
+
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = 0; j < i; j++) {
+            if (strcmp(ids[i], ids[j]) == 0) {
+                fprintf(stderr, "cataloggen: duplicate id %s\n", ids[i]);
+                return 1;
+            }
+        }
+        bucket_of[i] = sweetexp_catalog_hash(ids[i], 0) % n;
+        order[i] = i;
+        displace[i] = 0;
+        slot_index[i] = -1;
+        taken[i] = 0;
+    }
+
+    // Place the largest buckets first while most slots are still free
+    for (uint32_t i = 1; i < n; i++) {
+        for (uint32_t j = i; j > 0 && bucket_size(bucket_of, order[j]) > bucket_size(bucket_of, order[j - 1]); j--) {
+            uint32_t t = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = t;
+        }
+    }
+
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t bucket = order[k];
+        if (bucket_size(bucket_of, bucket) == 0) continue;
+
+        uint32_t d;
+        for (d = 1; d <= MAX_DISPLACEMENT; d++) {
+            uint32_t slots[ID_COUNT];
+            int count = 0, ok = 1;
+            for (uint32_t i = 0; i < n && ok; i++) {
+                if (bucket_of[i] != bucket) continue;
+                uint32_t s = sweetexp_catalog_hash(ids[i], d) % n;
+                if (taken[s]) ok = 0;
+                for (int c = 0; c < count && ok; c++) ok = slots[c] != s;
+                slots[count++] = s;
+            }
+            if (!ok) continue;
+            count = 0;
+            for (uint32_t i = 0; i < n; i++) {
+                if (bucket_of[i] != bucket) continue;
+                taken[slots[count++]] = 1;
+                slot_index[slots[count - 1]] = (int)i;
+            }
+            break;
+        }
+        if (d > MAX_DISPLACEMENT) {
+            fprintf(stderr, "cataloggen: no displacement found for bucket %u\n", bucket);
+            return 1;
+        }
+        displace[bucket] = d;
+    }
+
+    printf("// Generated by SweetExpCatalogGen.c from sweetexp_catalog.h - do not edit\n");
+    printf("#ifndef SWEETEXP_CATALOG_HASH_H\n#define SWEETEXP_CATALOG_HASH_H\n\n");
+    printf("#define SWEETEXP_CATALOG_HASH_COUNT %u\n\n", n);
+    printf("static const uint16_t sweetexp_catalog_displace[SWEETEXP_CATALOG_HASH_COUNT] = {");
+    for (uint32_t i = 0; i < n; i++) printf("%s%u", i ? ", " : "", displace[i]);
+    printf("};\n\n");
+    printf("// Slot -> catalogue index\n");
+    printf("static const uint8_t sweetexp_catalog_slot[SWEETEXP_CATALOG_HASH_COUNT] = {");
+    for (uint32_t i = 0; i < n; i++) printf("%s%d", i ? ", " : "", slot_index[i]);
+    printf("};\n\n#endif // SWEETEXP_CATALOG_HASH_H\n");
+    return 0;
+}
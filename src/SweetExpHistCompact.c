@@ -0,0 +1,544 @@
+/**
+ * SweetExpHistCompact.c - Compact and query NotifEngine's notification history
+ * notif_data.dat grows by one JSON line per notification forever. The compact
+ * pass moves those lines into notif_data.seg (see NOTIFICATION HISTORY SEGMENT in
+ * sweetexp_abi.h): lines older than the retention window are dropped or appended
+ * to an archive, the rest are merged with the existing segment, sorted by
+ * timestamp and written with a sparse time index. The last and since queries
+ * seek through that index and read only the lines they print.
+ * Author: Custom Lumen OS Development
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ *
+ * Usage: sweetexp_histcompact [-l log] [-g segment] [-r days] [-a archive] [-i stride] compact
+ *        sweetexp_histcompact [-l log] [-g segment] last <N>
+ *        sweetexp_histcompact [-l log] [-g segment] since <epoch>
+ *        sweetexp_histcompact [-g segment] stat
+ *
+ * Defaults: SWEETEXP_HIST_RETENTION_DAYS retention (the window a default
+ * backfill replays), no archive (old lines are dropped), an index entry every
+ * 256 records. Lines without a "timestamp" cannot be placed in the segment; they
+ * are archived or dropped like old lines and counted as no_timestamp.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <libgen.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sweetexp_abi.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HIST_SCAN_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HIST_SCAN_NEON 1
+#endif
+
+#define HIST_DEFAULT_STRIDE 256
+
+typedef struct {
+    int64_t timestamp;
+    const char* line;
+    uint32_t len;               // Without the '\n'
+    uint32_t order;             // Input position, keeps equal timestamps in file order
+} HistRecord;
+
+typedef struct {
+    HistRecord* records;
+    size_t count;
+    size_t capacity;
+} HistList;
+
+typedef struct {
+    char* data;
+    size_t size;
+    struct stat st;
+} MappedFile;
+
+// ==================== NEWLINE SCANNER ====================
+// First '\n' in [p, end), or end. The vector versions compare 16 (SSE2, NEON)
+// or 64 (AVX2, two registers) bytes per step and locate the hit from a bitmask.
+
+typedef const char* (*newline_fn)(const char* p, const char* end);
+
+static const char* newline_scalar(const char* p, const char* end) {
+    while (p < end && *p != '\n') p++;
+    return p;
+}
+
+#ifdef HIST_SCAN_X86
+static const char* newline_sse2(const char* p, const char* end) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    for (; p + 16 <= end; p += 16) {
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), nl));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return newline_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* newline_avx2(const char* p, const char* end) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    for (; p + 64 <= end; p += 64) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), nl);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)), nl);
+        if (_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b))) continue;
+        uint64_t mask = (uint32_t)_mm256_movemask_epi8(a) | (uint64_t)(uint32_t)_mm256_movemask_epi8(b) << 32;
+        return p + __builtin_ctzll(mask);
+    }
+    return newline_sse2(p, end);
+}
+#endif
+
+#ifdef HIST_SCAN_NEON
+static const char* newline_neon(const char* p, const char* end) {
+    const uint8x16_t nl = vdupq_n_u8('\n');
+    for (; p + 16 <= end; p += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8((const uint8_t*)p), nl);
+        // Narrow each byte to a nibble: 64 bits, four per input byte
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if (bits) return p + (__builtin_ctzll(bits) >> 2);
+    }
+    return newline_scalar(p, end);
+}
+#endif
+
+static newline_fn newline_select(void) {
+#if defined(HIST_SCAN_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? newline_avx2 : newline_sse2;
+#elif defined(HIST_SCAN_NEON)
+    return newline_neon;
+#else
+    return newline_scalar;
+#endif
+}
+
+static newline_fn find_newline;
+
+// ==================== LINES ====================
+
+// "timestamp" of a history line, -1 if it has none
+static int64_t line_timestamp(const char* line, size_t len) {
+    const char* p = memmem(line, len, "\"timestamp\"", 11);
+    if (!p) return -1;
+    const char* end = line + len;
+    p += 11;
+    while (p < end && (*p == ' ' || *p == ':')) p++;
+    if (p == end || *p < '0' || *p > '9') return -1;
+    int64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    return v;
+}
+
+static int list_push(HistList* l, int64_t timestamp, const char* line, size_t len) {
+    if (l->count == l->capacity) {
+        size_t capacity = l->capacity ? l->capacity * 2 : 4096;
+        HistRecord* grown = realloc(l->records, capacity * sizeof(HistRecord));
+        if (!grown) return -1;
+        l->records = grown;
+        l->capacity = capacity;
+    }
+    l->records[l->count] = (HistRecord){timestamp, line, (uint32_t)len, (uint32_t)l->count};
+    l->count++;
+    return 0;
+}
+
+// Append every non-empty line of [data, data + size) to `l`
+static int scan_lines(HistList* l, const char* data, size_t size) {
+    const char* end = data + size;
+    for (const char* p = data; p < end;) {
+        const char* nl = find_newline(p, end);
+        if (nl > p && list_push(l, line_timestamp(p, (size_t)(nl - p)), p, (size_t)(nl - p)) < 0) return -1;
+        p = nl + 1;
+    }
+    return 0;
+}
+
+static int record_cmp(const void* a, const void* b) {
+    const HistRecord* x = a;
+    const HistRecord* y = b;
+    if (x->timestamp != y->timestamp) return x->timestamp < y->timestamp ? -1 : 1;
+    return x->order < y->order ? -1 : x->order > y->order;
+}
+
+static int map_file(const char* path, MappedFile* f) {
+    memset(f, 0, sizeof(*f));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return errno == ENOENT ? 0 : -1;
+    if (fstat(fd, &f->st) < 0) {
+        close(fd);
+        return -1;
+    }
+    f->size = (size_t)f->st.st_size;
+    if (f->size > 0) {
+        f->data = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (f->data == MAP_FAILED) {
+            f->data = NULL;
+            close(fd);
+            return -1;
+        }
+        madvise(f->data, f->size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    return 1;
+}
+
+static void unmap_file(MappedFile* f) {
+    if (f->data) munmap(f->data, f->size);
+    memset(f, 0, sizeof(*f));
+}
+
+// ==================== SEGMENT ====================
+
+static const sweetexp_hist_header* segment_header(const MappedFile* f) {
+    return f->data ? sweetexp_hist_validate(f->data, f->size) : NULL;
+}
+
+static const sweetexp_hist_index* segment_index(const MappedFile* f, const sweetexp_hist_header* h) {
+    return (const sweetexp_hist_index*)(f->data + h->index_offset);
+}
+
+static const sweetexp_hist_index* segment_seek_time(const MappedFile* f, const sweetexp_hist_header* h, int64_t since) {
+    return sweetexp_hist_seek(segment_index(f, h), h->index_count, since);
+}
+
+// Write `h`, the sorted lines and their index to a temp file, then rename over `path`
+static int write_segment(const char* path, const HistRecord* records, size_t count, uint32_t stride,
+                         sweetexp_hist_header* h) {
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* fp = fopen(tmp, "wb");
+    if (!fp) return -1;
+
+    size_t index_count = count ? (count - 1) / stride + 1 : 0;
+    sweetexp_hist_index* index = calloc(index_count ? index_count : 1, sizeof(*index));
+    if (!index) {
+        fclose(fp);
+        unlink(tmp);
+        return -1;
+    }
+
+    memcpy(h->magic, SWEETEXP_HIST_MAGIC, sizeof(SWEETEXP_HIST_MAGIC) - 1);
+    h->version = SWEETEXP_HIST_VERSION;
+    h->header_size = sizeof(*h);
+    h->record_count = count;
+    h->data_offset = sizeof(*h);
+    h->index_stride = stride;
+    h->first_timestamp = count ? records[0].timestamp : 0;
+    h->last_timestamp = count ? records[count - 1].timestamp : 0;
+
+    int failed = fseek(fp, (long)sizeof(*h), SEEK_SET) != 0;
+    uint64_t offset = 0;
+    for (size_t i = 0; i < count && !failed; i++) {
+        if (i % stride == 0) index[i / stride] = (sweetexp_hist_index){records[i].timestamp, i, offset};
+        failed = fwrite(records[i].line, 1, records[i].len, fp) != records[i].len || fputc('\n', fp) == EOF;
+        offset += records[i].len + 1;
+    }
+    static const uint8_t zero_pad[8];
+    size_t pad = (8 - (sizeof(*h) + offset) % 8) % 8;
+    h->data_size = offset;
+    h->index_offset = sizeof(*h) + offset + pad;
+    h->index_count = (uint32_t)index_count;
+    h->crc32 = sweetexp_crc32(sweetexp_crc32(0, h, offsetof(sweetexp_hist_header, crc32)), index,
+                              index_count * sizeof(*index));
+    if (!failed) failed = fwrite(zero_pad, 1, pad, fp) != pad ||
+                          fwrite(index, sizeof(*index), index_count, fp) != index_count ||
+                          fseek(fp, 0, SEEK_SET) != 0 || fwrite(h, sizeof(*h), 1, fp) != 1;
+    free(index);
+    if (fflush(fp) != 0 || fsync(fileno(fp)) < 0) failed = 1;
+    if (fclose(fp) != 0) failed = 1;
+    if (failed || rename(tmp, path) < 0) {
+        unlink(tmp);
+        return -1;
+    }
+
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", path);
+    int dir_fd = open(dirname(dir), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    return 0;
+}
+
+// ==================== COMMANDS ====================
+
+typedef struct {
+    const char* log_path;
+    const char* segment_path;
+    const char* archive_path;
+    int retention_days;
+    uint32_t stride;
+} HistOptions;
+
+static int cmd_compact(const HistOptions* o) {
+    char compacting[PATH_MAX];
+    snprintf(compacting, sizeof(compacting), "%s.compacting", o->log_path);
+
+    MappedFile seg, pending;
+    if (map_file(o->segment_path, &seg) < 0) {
+        fprintf(stderr, "histcompact: cannot read %s: %s\n", o->segment_path, strerror(errno));
+        return 1;
+    }
+    const sweetexp_hist_header* old = seg.data ? segment_header(&seg) : NULL;
+    if (seg.data && !old) {
+        fprintf(stderr, "histcompact: %s is corrupt; move it aside to rebuild\n", o->segment_path);
+        return 1;
+    }
+
+    // Take the log out of NotifEngine's way unless a previous pass left one behind
+    if (access(compacting, F_OK) != 0 && rename(o->log_path, compacting) < 0 && errno != ENOENT) {
+        fprintf(stderr, "histcompact: cannot move %s aside: %s\n", o->log_path, strerror(errno));
+        return 1;
+    }
+    if (map_file(compacting, &pending) < 0) {
+        fprintf(stderr, "histcompact: cannot read %s: %s\n", compacting, strerror(errno));
+        return 1;
+    }
+    if (old && pending.data && old->consumed_inode == (uint64_t)pending.st.st_ino &&
+        old->consumed_size == (uint64_t)pending.size) {
+        unmap_file(&pending);  // Already in the segment: a previous pass stopped before deleting it
+        unlink(compacting);
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int64_t now = (int64_t)time(NULL);
+    int64_t cutoff = now - (int64_t)o->retention_days * 86400;
+
+    // Segment lines are sorted already; sort the new ones and merge
+    HistList kept = {NULL, 0, 0}, fresh = {NULL, 0, 0};
+    size_t skipped = 0;
+    if (old) {
+        const char* data = seg.data + old->data_offset;
+        const sweetexp_hist_index* start = segment_seek_time(&seg, old, cutoff);
+        size_t skip = start ? (size_t)start->offset : 0;
+        skipped = start ? (size_t)start->record : 0;
+        // Lines before the seek point are all older than the cutoff
+        if (scan_lines(&kept, data + skip, (size_t)old->data_size - skip) < 0) goto oom;
+        if (o->archive_path) {
+            HistList head = {NULL, 0, 0};
+            if (scan_lines(&head, data, skip) < 0) goto oom;
+            for (size_t i = 0; i < head.count; i++) {
+                if (list_push(&fresh, head.records[i].timestamp, head.records[i].line, head.records[i].len) < 0) goto oom;
+            }
+            free(head.records);
+            skipped = 0;  // Merged below and counted as archived
+        }
+    }
+    size_t from_segment = kept.count + fresh.count + skipped;
+    if (pending.data && scan_lines(&fresh, pending.data, pending.size) < 0) goto oom;
+    size_t scanned = fresh.count + kept.count + skipped;
+    qsort(fresh.records, fresh.count, sizeof(HistRecord), record_cmp);
+
+    HistRecord* merged = malloc((kept.count + fresh.count + 1) * sizeof(HistRecord));
+    if (!merged) goto oom;
+    size_t count = 0, archived = 0, dropped = skipped, untimestamped = 0, i = 0, j = 0;
+    FILE* archive = NULL;
+    if (o->archive_path && !(archive = fopen(o->archive_path, "ab"))) {
+        fprintf(stderr, "histcompact: cannot open archive %s: %s\n", o->archive_path, strerror(errno));
+        free(merged);
+        goto fail;
+    }
+    while (i < kept.count || j < fresh.count) {
+        const HistRecord* r = j == fresh.count || (i < kept.count && kept.records[i].timestamp <= fresh.records[j].timestamp)
+                                  ? &kept.records[i++]
+                                  : &fresh.records[j++];
+        if (r->timestamp >= cutoff) {
+            merged[count++] = *r;
+            continue;
+        }
+        if (r->timestamp < 0) untimestamped++;
+        if (archive) {
+            fwrite(r->line, 1, r->len, archive);
+            fputc('\n', archive);
+            archived += r->timestamp >= 0;
+        } else if (r->timestamp >= 0) {
+            dropped++;
+        }
+    }
+    if (archive && (fflush(archive) != 0 || fsync(fileno(archive)) < 0 || fclose(archive) != 0)) {
+        fprintf(stderr, "histcompact: cannot write archive %s\n", o->archive_path);
+        free(merged);
+        goto fail;
+    }
+
+    sweetexp_hist_header h;
+    memset(&h, 0, sizeof(h));
+    h.compacted_at = now;
+    h.retention_cutoff = cutoff;
+    h.consumed_inode = pending.data ? (uint64_t)pending.st.st_ino : 0;
+    h.consumed_size = pending.size;
+    int rc = write_segment(o->segment_path, merged, count, o->stride, &h);
+    free(merged);
+    if (rc < 0) {
+        fprintf(stderr, "histcompact: cannot write %s: %s\n", o->segment_path, strerror(errno));
+        goto fail;
+    }
+    unlink(compacting);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    printf("scanned=%zu (segment %zu, new %zu) kept=%zu archived=%zu dropped=%zu no_timestamp=%zu (%s) index=%u "
+           "elapsed=%.3fs\n",
+           scanned, from_segment, scanned - from_segment, count, archived, dropped, untimestamped,
+           o->archive_path ? "archived" : "dropped", h.index_count,
+           (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9);
+    free(kept.records);
+    free(fresh.records);
+    unmap_file(&seg);
+    unmap_file(&pending);
+    return 0;
+
+oom:
+    fprintf(stderr, "histcompact: out of memory\n");
+fail:
+    free(kept.records);
+    free(fresh.records);
+    unmap_file(&seg);
+    unmap_file(&pending);
+    return 1;
+}
+
+// Lines not compacted yet: a leftover .compacting log, then the live log
+static int load_pending(const HistOptions* o, const sweetexp_hist_header* h, MappedFile files[2], HistList* lines) {
+    char compacting[PATH_MAX];
+    snprintf(compacting, sizeof(compacting), "%s.compacting", o->log_path);
+    const char* paths[2] = {compacting, o->log_path};
+    for (int k = 0; k < 2; k++) {
+        if (map_file(paths[k], &files[k]) < 0) {
+            fprintf(stderr, "histcompact: cannot read %s: %s\n", paths[k], strerror(errno));
+            return -1;
+        }
+        if (k == 0 && h && files[0].data && h->consumed_inode == (uint64_t)files[0].st.st_ino &&
+            h->consumed_size == (uint64_t)files[0].size) {
+            continue;  // Already in the segment
+        }
+        if (files[k].data && scan_lines(lines, files[k].data, files[k].size) < 0) return -1;
+    }
+    return 0;
+}
+
+static void print_line(const char* line, size_t len) {
+    fwrite(line, 1, len, stdout);
+    fputc('\n', stdout);
+}
+
+// Print segment lines starting at `entry`, skipping `skip` records, then those
+// at or after `since`
+static void print_segment_from(const MappedFile* seg, const sweetexp_hist_header* h, const sweetexp_hist_index* entry,
+                               uint64_t skip, int64_t since) {
+    const char* p = seg->data + h->data_offset + entry->offset;
+    const char* end = seg->data + h->data_offset + h->data_size;
+    while (p < end) {
+        const char* nl = find_newline(p, end);
+        if (skip > 0) skip--;
+        else if (line_timestamp(p, (size_t)(nl - p)) >= since) print_line(p, (size_t)(nl - p));
+        p = nl + 1;
+    }
+}
+
+static int cmd_query(const HistOptions* o, int last, long long arg) {
+    MappedFile seg, files[2];
+    memset(files, 0, sizeof(files));
+    if (map_file(o->segment_path, &seg) < 0) {
+        fprintf(stderr, "histcompact: cannot read %s: %s\n", o->segment_path, strerror(errno));
+        return 1;
+    }
+    const sweetexp_hist_header* h = seg.data ? segment_header(&seg) : NULL;
+    if (seg.data && !h) fprintf(stderr, "histcompact: %s is corrupt, ignoring it\n", o->segment_path);
+
+    HistList pending = {NULL, 0, 0};
+    int rc = load_pending(o, h, files, &pending);
+    if (rc == 0) {
+        if (last) {
+            uint64_t n = arg > 0 ? (uint64_t)arg : 0;
+            uint64_t from_pending = n < pending.count ? n : pending.count;
+            uint64_t from_segment = h && n - from_pending < h->record_count ? n - from_pending : h ? h->record_count : 0;
+            if (h && from_segment > 0) {
+                uint64_t first = h->record_count - from_segment;
+                const sweetexp_hist_index* entry = &segment_index(&seg, h)[first / h->index_stride];
+                print_segment_from(&seg, h, entry, first - entry->record, INT64_MIN);
+            }
+            for (size_t i = pending.count - from_pending; i < pending.count; i++) {
+                print_line(pending.records[i].line, pending.records[i].len);
+            }
+        } else {
+            int64_t since = (int64_t)arg;
+            const sweetexp_hist_index* entry = h && h->last_timestamp >= since ? segment_seek_time(&seg, h, since) : NULL;
+            if (entry) print_segment_from(&seg, h, entry, 0, since);
+            for (size_t i = 0; i < pending.count; i++) {
+                if (pending.records[i].timestamp >= since) print_line(pending.records[i].line, pending.records[i].len);
+            }
+        }
+    }
+    free(pending.records);
+    unmap_file(&files[0]);
+    unmap_file(&files[1]);
+    unmap_file(&seg);
+    return rc < 0 ? 1 : 0;
+}
+
+static int cmd_stat(const HistOptions* o) {
+    MappedFile seg;
+    if (map_file(o->segment_path, &seg) <= 0 || !seg.data) {
+        fprintf(stderr, "histcompact: no segment at %s\n", o->segment_path);
+        return 1;
+    }
+    const sweetexp_hist_header* h = segment_header(&seg);
+    if (!h) {
+        fprintf(stderr, "histcompact: %s is corrupt\n", o->segment_path);
+        unmap_file(&seg);
+        return 1;
+    }
+    printf("records=%llu data=%llu bytes index=%u x%u first=%lld last=%lld compacted=%lld cutoff=%lld\n",
+           (unsigned long long)h->record_count, (unsigned long long)h->data_size, h->index_count, h->index_stride,
+           (long long)h->first_timestamp, (long long)h->last_timestamp, (long long)h->compacted_at,
+           (long long)h->retention_cutoff);
+    unmap_file(&seg);
+    return 0;
+}
+
+static int usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-l log] [-g segment] [-r days] [-a archive] [-i stride] compact\n"
+                    "       %s [-l log] [-g segment] last <N>\n"
+                    "       %s [-l log] [-g segment] since <epoch>\n"
+                    "       %s [-g segment] stat\n", prog, prog, prog, prog);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    HistOptions o = {SWEETEXP_HIST_LOG_PATH, SWEETEXP_HIST_SEGMENT_PATH, NULL, SWEETEXP_HIST_RETENTION_DAYS,
+                     HIST_DEFAULT_STRIDE};
+    int opt;
+    while ((opt = getopt(argc, argv, "l:g:r:a:i:")) != -1) {
+        switch (opt) {
+            case 'l': o.log_path = optarg; break;
+            case 'g': o.segment_path = optarg; break;
+            case 'r': o.retention_days = atoi(optarg); break;
+            case 'a': o.archive_path = optarg; break;
+            case 'i': o.stride = (uint32_t)strtoul(optarg, NULL, 10); break;
+            default: return usage(argv[0]);
+        }
+    }
+    if (optind >= argc || o.retention_days <= 0 || o.stride == 0) return usage(argv[0]);
+    find_newline = newline_select();
+
+    const char* cmd = argv[optind];
+    if (strcmp(cmd, "compact") == 0) return cmd_compact(&o);
+    if (strcmp(cmd, "stat") == 0) return cmd_stat(&o);
+    if ((strcmp(cmd, "last") == 0 || strcmp(cmd, "since") == 0) && optind + 1 < argc) {
+        return cmd_query(&o, cmd[0] == 'l', strtoll(argv[optind + 1], NULL, 10));
+    }
+    return usage(argv[0]);
+}
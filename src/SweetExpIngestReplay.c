@@ -0,0 +1,234 @@
+/**
+ * SweetExpIngestReplay.c - Stand-in event source for the SweetEngine ingest socket
+ * Replays a Wayland event trace (or a synthetic one) from several concurrent
+ * clients and reports the achieved event rate, so the ingestion path can be
+ * benchmarked without a compositor.
+ * Author: Custom Lumen OS Development
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ *
+ * Usage: sweetexp_ingest_replay [-c clients] [-n events_per_client] [-b batch]
+ *                               [-u users] [-m metric_name] [-t trace_file] [-s socket]
+ *
+ * Trace files hold one event per line: "<user_id> <delta>"; '#' starts a comment.
+ * Without -t a synthetic trace of input bursts (pointer motion, key repeat) is used.
+ * With -m events go to a named metric bound on the connection instead of wayland_events.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "sweetexp_abi.h"
+
+#define REPLAY_MAX_CLIENTS 256
+#define REPLAY_NAMED_SLOT 32
+
+typedef struct {
+    int32_t user_id;
+    int32_t delta;
+} TraceEvent;
+
+typedef struct {
+    const char* socket_path;
+    const char* metric_name;
+    const TraceEvent* trace;
+    size_t trace_len;
+    long events;
+    int batch;
+    int index;
+    long sent;
+    int failed;
+} ReplayClient;
+
+static int write_all(int fd, const void* buf, size_t len) {
+    const uint8_t* p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Synthetic trace: bursts of motion events (small deltas) with occasional key repeats
+static TraceEvent* synth_trace(size_t len, int users) {
+    TraceEvent* trace = malloc(len * sizeof(TraceEvent));
+    if (!trace) return NULL;
+    unsigned int seed = 0x5EE7u;
+    int user = 0;
+    int burst = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (burst == 0) {
+            user = (int)(rand_r(&seed) % (unsigned)users);
+            burst = 8 + (int)(rand_r(&seed) % 120);
+        }
+        trace[i].user_id = user;
+        trace[i].delta = rand_r(&seed) % 16 == 0 ? 4 : 1;
+        burst--;
+    }
+    return trace;
+}
+
+static TraceEvent* load_trace(const char* path, size_t* len) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return NULL;
+
+    size_t cap = 4096, n = 0;
+    TraceEvent* trace = malloc(cap * sizeof(TraceEvent));
+    char line[128];
+    while (trace && fgets(line, sizeof(line), fp)) {
+        int user, delta;
+        if (line[0] == '#' || sscanf(line, "%d %d", &user, &delta) != 2) continue;
+        if (n == cap) {
+            TraceEvent* grown = realloc(trace, cap * 2 * sizeof(TraceEvent));
+            if (!grown) break;
+            trace = grown;
+            cap *= 2;
+        }
+        trace[n].user_id = user;
+        trace[n].delta = delta;
+        n++;
+    }
+    fclose(fp);
+    *len = n;
+    return trace;
+}
+
+static void* replay_client_thread(void* arg) {
+    ReplayClient* c = arg;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, c->socket_path, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "ingest_replay: connect %s: %s\n", c->socket_path, strerror(errno));
+        c->failed = 1;
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+
+    uint16_t slot = SWEETEXP_METRIC_WAYLAND_EVENTS;
+    if (c->metric_name) {
+        struct {
+            sweetexp_ingest_frame frame;
+            sweetexp_ingest_bind bind;
+        } msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.frame.magic = SWEETEXP_INGEST_MAGIC;
+        msg.frame.type = SWEETEXP_INGEST_BIND;
+        msg.frame.count = 1;
+        msg.bind.slot = REPLAY_NAMED_SLOT;
+        memcpy(msg.bind.name, c->metric_name, strnlen(c->metric_name, sizeof(msg.bind.name)));
+        write_all(fd, &msg, sizeof(msg));
+        slot = REPLAY_NAMED_SLOT;
+    }
+
+    // Each client starts at a different point of the trace so users interleave
+    size_t pos = (c->trace_len / REPLAY_MAX_CLIENTS) * (size_t)c->index;
+    size_t frame_size = sizeof(sweetexp_ingest_frame) + (size_t)c->batch * sizeof(sweetexp_ingest_event);
+    uint8_t* buf = malloc(frame_size);
+    sweetexp_ingest_frame* frame = (sweetexp_ingest_frame*)buf;
+    sweetexp_ingest_event* records = (sweetexp_ingest_event*)(buf + sizeof(*frame));
+
+    while (buf && c->sent < c->events) {
+        int count = c->events - c->sent < c->batch ? (int)(c->events - c->sent) : c->batch;
+        frame->magic = SWEETEXP_INGEST_MAGIC;
+        frame->type = SWEETEXP_INGEST_EVENTS;
+        frame->count = (uint16_t)count;
+        for (int i = 0; i < count; i++) {
+            const TraceEvent* ev = &c->trace[pos];
+            pos = pos + 1 == c->trace_len ? 0 : pos + 1;
+            records[i].slot = slot;
+            records[i].reserved = 0;
+            records[i].user_id = ev->user_id;
+            records[i].delta = ev->delta;
+        }
+        if (write_all(fd, buf, sizeof(*frame) + (size_t)count * sizeof(*records)) < 0) {
+            fprintf(stderr, "ingest_replay: client %d: %s\n", c->index, strerror(errno));
+            c->failed = 1;
+            break;
+        }
+        c->sent += count;
+    }
+    free(buf);
+    close(fd);
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    int clients = 4, batch = 128, users = 16;
+    long events = 1000000;
+    const char* trace_path = NULL;
+    const char* metric_name = NULL;
+    const char* socket_path = SWEETEXP_INGEST_SOCK;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:b:u:m:t:s:")) != -1) {
+        switch (opt) {
+            case 'c': clients = atoi(optarg); break;
+            case 'n': events = atol(optarg); break;
+            case 'b': batch = atoi(optarg); break;
+            case 'u': users = atoi(optarg); break;
+            case 'm': metric_name = optarg; break;
+            case 't': trace_path = optarg; break;
+            case 's': socket_path = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-c clients] [-n events_per_client] [-b batch] [-u users] "
+                                "[-m metric_name] [-t trace_file] [-s socket]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (clients < 1 || clients > REPLAY_MAX_CLIENTS || batch < 1 || batch > SWEETEXP_INGEST_MAX_RECORDS ||
+        users < 1 || events < 0) {
+        fprintf(stderr, "ingest_replay: clients 1-%d, batch 1-%d, users >= 1\n",
+                REPLAY_MAX_CLIENTS, SWEETEXP_INGEST_MAX_RECORDS);
+        return 2;
+    }
+
+    size_t trace_len = 1 << 16;
+    TraceEvent* trace = trace_path ? load_trace(trace_path, &trace_len) : synth_trace(trace_len, users);
+    if (!trace || trace_len == 0) {
+        fprintf(stderr, "ingest_replay: no events to replay\n");
+        return 1;
+    }
+
+    ReplayClient* state = calloc((size_t)clients, sizeof(ReplayClient));
+    pthread_t* threads = calloc((size_t)clients, sizeof(pthread_t));
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < clients; i++) {
+        state[i] = (ReplayClient){socket_path, metric_name, trace, trace_len, events, batch, i, 0, 0};
+        pthread_create(&threads[i], NULL, replay_client_thread, &state[i]);
+    }
+
+    long total = 0;
+    int failed = 0;
+    for (int i = 0; i < clients; i++) {
+        pthread_join(threads[i], NULL);
+        total += state[i].sent;
+        failed |= state[i].failed;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("clients=%d batch=%d events=%ld elapsed=%.3fs rate=%.0f events/s\n",
+           clients, batch, total, secs, secs > 0 ? (double)total / secs : 0.0);
+
+    free(threads);
+    free(state);
+    free(trace);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * SweetExpLevelBench.c - Benchmark BootSecurityManager's prevent_power_action logging
+ * Times one prevent_power_action() check (bootloader stat, USB sysfs read, state
+ * update under the manager lock, and its five log lines) four ways:
+ *   before    the original log_message(): vsnprintf, lumen_log, XOR pass per call
+ *   lumenlog  LLOG_* macros with every level enabled
+ *   runtime   LLOG_* with lumenlog_set_level(LUMENLOG_WARNING): one load per call
+ *   compiled  LLOG_* built with LUMENLOG_COMPILE_LEVEL=2: DEBUG/INFO calls gone
+ * The probe files are stand-ins created under /tmp, so the numbers isolate the
+ * logging cost rather than sysfs.
+ * Author: Custom Lumen OS Development
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ *
+ * Build: with LumenLog.c
+ * Usage: sweetexp_levelbench [checks]     (default 200000)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "lumenlog.h"
+
+#define LOG_TAG "BootSecurityManager"
+#define MAX_LOG_BUFFER 1024
+#define BOOTLOADER_STANDIN "/tmp/sweetexp_levelbench_bootloader"
+#define USB_STANDIN "/tmp/sweetexp_levelbench_usb"
+#define LOG_STANDIN "/tmp/sweetexp_levelbench.log"
+
+static struct {
+    pthread_mutex_t lock;
+    int bootloader_present;
+    int usb_plugged;
+    int current_state;
+    int sink_fd;                        // lumen_log stand-in for the "before" path
+} mgr = {PTHREAD_MUTEX_INITIALIZER, 0, 0, 0, -1};
+
+// The original log_message(): format, hand to lumen_log, then the XOR pass that
+// encrypt_log() ran on a copy of every message
+static void log_message_before(const char* level, const char* fmt, ...) {
+    char buffer[MAX_LOG_BUFFER];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, MAX_LOG_BUFFER, fmt, args);
+    va_end(args);
+    dprintf(mgr.sink_fd, "%s %s: %s\n", LOG_TAG, level, buffer);
+    char* enc = strdup(buffer);
+    for (size_t i = 0; i < strlen(enc); i++) {
+        enc[i] ^= 0xAA;
+    }
+    free(enc);
+}
+
+#define LOG_BEFORE_DEBUG(...) log_message_before("DEBUG", __VA_ARGS__)
+#define LOG_BEFORE_INFO(...) log_message_before("INFO", __VA_ARGS__)
+#define LOG_BEFORE_WARNING(...) log_message_before("WARNING", __VA_ARGS__)
+#define LOG_BEFORE_ERROR(...) log_message_before("ERROR", __VA_ARGS__)
+#define LOG_AFTER_DEBUG(...) LLOG_DEBUG(LOG_TAG, __VA_ARGS__)
+#define LOG_AFTER_INFO(...) LLOG_INFO(LOG_TAG, __VA_ARGS__)
+#define LOG_AFTER_WARNING(...) LLOG_WARNING(LOG_TAG, __VA_ARGS__)
+#define LOG_AFTER_ERROR(...) LLOG_ERROR(LOG_TAG, __VA_ARGS__)
+
+// prevent_power_action() and the checks it calls, with the logging of variant V
+#define DEFINE_POWER_CHECK(name, V) \
+    static int name(int action) { \
+        struct stat st; \
+        if (stat(BOOTLOADER_STANDIN, &st) == 0) { \
+            LOG_##V##_INFO("Bootloader path exists."); \
+            mgr.bootloader_present = 1; \
+        } else { \
+            LOG_##V##_WARNING("Bootloader path missing."); \
+            mgr.bootloader_present = 0; \
+        } \
+        int fd = open(USB_STANDIN, O_RDONLY); \
+        char buf[2] = {0}; \
+        if (fd < 0 || read(fd, buf, 1) != 1) { \
+            LOG_##V##_ERROR("Failed to read USB status: %s", strerror(errno)); \
+            mgr.usb_plugged = -1; \
+        } else { \
+            mgr.usb_plugged = buf[0] == '1'; \
+            LOG_##V##_INFO("USB plugged: %d", mgr.usb_plugged); \
+        } \
+        if (fd >= 0) close(fd); \
+        pthread_mutex_lock(&mgr.lock); \
+        mgr.current_state = mgr.bootloader_present <= 0 ? 1 : (mgr.usb_plugged == 0 ? 2 : 0); \
+        pthread_mutex_unlock(&mgr.lock); \
+        LOG_##V##_DEBUG("Updated state to %d", mgr.current_state); \
+        if (mgr.current_state != 0 && mgr.usb_plugged != 1) { \
+            LOG_##V##_WARNING("Preventing power action %d: USB not plugged.", action); \
+            return -1; \
+        } \
+        LOG_##V##_INFO("Allowing power action %d.", action); \
+        return 0; \
+    }
+
+DEFINE_POWER_CHECK(check_before, BEFORE)
+DEFINE_POWER_CHECK(check_after, AFTER)
+// LLOG reads the floor where it expands, so this copy drops DEBUG and INFO
+#undef LUMENLOG_COMPILE_LEVEL
+#define LUMENLOG_COMPILE_LEVEL 2
+DEFINE_POWER_CHECK(check_compiled, AFTER)
+
+static double elapsed_ns(const struct timespec* a, const struct timespec* b) {
+    return (double)(b->tv_sec - a->tv_sec) * 1e9 + (double)(b->tv_nsec - a->tv_nsec);
+}
+
+static int write_file(const char* path, const char* text) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    ssize_t n = write(fd, text, strlen(text));
+    close(fd);
+    return n == (ssize_t)strlen(text) ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    long checks = argc > 1 ? atol(argv[1]) : 200000;
+    if (checks <= 0) {
+        fprintf(stderr, "Usage: %s [checks]\n", argv[0]);
+        return 2;
+    }
+    if (write_file(BOOTLOADER_STANDIN, "lk\n") < 0 || write_file(USB_STANDIN, "1\n") < 0) {
+        perror("levelbench: probe files");
+        return 1;
+    }
+    unlink(LOG_STANDIN);
+    mgr.sink_fd = open(LOG_STANDIN, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    lumenlog_sink* file = lumenlog_file_sink(LOG_STANDIN);
+    if (mgr.sink_fd < 0 || !file || lumenlog_add_sink(file) < 0) {
+        fprintf(stderr, "levelbench: cannot open %s\n", LOG_STANDIN);
+        return 1;
+    }
+    lumenlog_set_overflow(LUMENLOG_OVERFLOW_BLOCK);
+    lumenlog_start();
+
+    static const struct {
+        const char* name;
+        int (*check)(int);
+        lumenlog_level runtime;
+    } variants[] = {
+        {"before", check_before, LUMENLOG_DEBUG},
+        {"lumenlog", check_after, LUMENLOG_DEBUG},
+        {"runtime", check_after, LUMENLOG_WARNING},
+        {"compiled", check_compiled, LUMENLOG_DEBUG},
+    };
+    printf("checks=%ld\n", checks);
+    double base = 0;
+    int allowed = 0;
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        lumenlog_set_level(variants[v].runtime);
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (long i = 0; i < checks; i++) allowed += variants[v].check((int)(i & 1)) == 0;
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        lumenlog_flush();
+        double ns = elapsed_ns(&t0, &t1) / (double)checks;
+        if (v == 0) base = ns;
+        printf("%-9s %8.0f ns/check  x%.1f\n", variants[v].name, ns, base / ns);
+    }
+    lumenlog_stop();
+    close(mgr.sink_fd);
+    unlink(LOG_STANDIN);
+    unlink(BOOTLOADER_STANDIN);
+    unlink(USB_STANDIN);
+    return allowed == checks * 4 ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/**
+ * SweetExpLogBench.c - Benchmark log_engine_event implementations
+ * Times one log call four ways: the original fopen/ctime/fprintf/fclose per
+ * event, one open O_APPEND fd with a write() per event, and the shared Lumen
+ * logger the engine now uses (LumenLog.c: format into a per-thread staging
+ * buffer, one flusher writing batches with a write() each), in text and in
+ * binary mode (arguments copied, no formatting; see LumenLogDecoder.c). The
+ * first two format with snprintf as the engine's callers did; lumenlog gets the
+ * format and arguments. For lumenlog the cost is what the caller pays; the
+ * flusher's drain time after the last call is reported separately, and the
+ * file size for each mode. lumenlog blocks when a staging buffer is full so
+ * every event reaches the file.
+ * Author: Custom Lumen OS Development
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ *
+ * Build: with LumenLog.c
+ * Usage: sweetexp_logbench [events] [threads] [log_path]
+ *        (default 100000 events per thread, 1 thread, /tmp/sweetexp_logbench.log)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "lumenlog.h"
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_TEXT 240
+#define STAMP_MAX 40
+
+typedef enum {
+    MODE_FOPEN_PER_CALL,
+    MODE_OPEN_FD,
+    MODE_LUMENLOG,
+    MODE_LUMENLOG_BINARY
+} BenchMode;
+
+static const char* const mode_names[] = {"fopen/call", "open fd", "lumenlog", "binary"};
+
+static struct {
+    const char* path;
+    BenchMode mode;
+    long events;
+    int fd;
+} bench;
+
+static double elapsed_s(const struct timespec* a, const struct timespec* b) {
+    return (double)(b->tv_sec - a->tv_sec) + (double)(b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+static size_t format_stamp(char* buf, time_t when) {
+    char ctime_buf[32];
+    ctime_r(&when, ctime_buf);
+    ctime_buf[strcspn(ctime_buf, "\n")] = '\0';
+    return (size_t)snprintf(buf, STAMP_MAX, "[%s] ", ctime_buf);
+}
+
+// The original log_engine_event
+static void log_fopen_per_call(const char* event) {
+    FILE* log = fopen(bench.path, "a");
+    if (log) {
+        time_t now = time(NULL);
+        char* time_str = ctime(&now);
+        time_str[strlen(time_str) - 1] = '\0';
+        fprintf(log, "[%s] %s\n", time_str, event);
+        fclose(log);
+    }
+}
+
+static void log_open_fd(const char* event) {
+    char line[STAMP_MAX + BENCH_TEXT];
+    size_t len = format_stamp(line, time(NULL));
+    len += (size_t)snprintf(line + len, BENCH_TEXT, "%s\n", event);
+    if (write(bench.fd, line, len) < 0) perror("logbench: write");
+}
+
+static void* producer(void* arg) {
+    long id = (long)arg;
+    char msg[BENCH_TEXT];
+    for (long i = 0; i < bench.events; i++) {
+        if (bench.mode >= MODE_LUMENLOG) {
+            lumenlog_write(LUMENLOG_INFO, "SweetEngine", "Achievement unlocked: bench_%ld for user %ld", i % 50, id);
+            continue;
+        }
+        snprintf(msg, sizeof(msg), "Achievement unlocked: bench_%ld for user %ld", i % 50, id);
+        if (bench.mode == MODE_FOPEN_PER_CALL) {
+            log_fopen_per_call(msg);
+        } else {
+            log_open_fd(msg);
+        }
+    }
+    return NULL;
+}
+
+static long count_lines(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return -1;
+    long lines = 0;
+    int c;
+    while ((c = getc_unlocked(fp)) != EOF) lines += c == '\n';
+    fclose(fp);
+    return lines;
+}
+
+// MESSAGE and TEXT records in a binary log
+static long count_records(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return -1;
+    long records = 0;
+    lumenlog_bin_header h;
+    while (fread(&h, sizeof(h), 1, fp) == 1 && h.size >= sizeof(h)) {
+        records += h.type == LUMENLOG_BIN_MESSAGE || h.type == LUMENLOG_BIN_TEXT;
+        if (fseek(fp, (long)(h.size - sizeof(h)), SEEK_CUR) != 0) break;
+    }
+    fclose(fp);
+    return records;
+}
+
+int main(int argc, char** argv) {
+    bench.events = argc > 1 ? atol(argv[1]) : 100000;
+    int threads = argc > 2 ? atoi(argv[2]) : 1;
+    bench.path = argc > 3 ? argv[3] : "/tmp/sweetexp_logbench.log";
+    if (bench.events <= 0 || threads <= 0 || threads > BENCH_MAX_THREADS) {
+        fprintf(stderr, "Usage: %s [events] [threads] [log_path]\n", argv[0]);
+        return 2;
+    }
+
+    printf("events=%ld threads=%d\n", bench.events, threads);
+    double base = 0;
+    int failed = 0;
+    for (int m = MODE_FOPEN_PER_CALL; m <= MODE_LUMENLOG_BINARY; m++) {
+        unlink(bench.path);
+        bench.mode = (BenchMode)m;
+        bench.fd = open(bench.path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (bench.fd < 0) {
+            perror("logbench: open");
+            return 1;
+        }
+        if (m >= MODE_LUMENLOG) {
+            // Sinks are kept for the process, so each mode filters on its own tag-less
+            // level: text takes INFO, binary everything from a sink added now
+            static lumenlog_sink* file;
+            lumenlog_sink* sink = m == MODE_LUMENLOG ? lumenlog_file_sink(bench.path)
+                                                     : lumenlog_binary_file_sink(bench.path);
+            if (!sink || lumenlog_add_sink(sink) < 0) {
+                fprintf(stderr, "logbench: cannot attach %s\n", bench.path);
+                return 1;
+            }
+            if (file) file->min_level = LUMENLOG_LEVELS;  // Retire the text sink
+            file = sink;
+            lumenlog_set_binary(m == MODE_LUMENLOG_BINARY);
+            lumenlog_set_overflow(LUMENLOG_OVERFLOW_BLOCK);
+            lumenlog_start();
+        }
+
+        struct timespec t0, t1, t2;
+        pthread_t workers[BENCH_MAX_THREADS];
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (long t = 0; t < threads; t++) pthread_create(&workers[t], NULL, producer, (void*)t);
+        for (int t = 0; t < threads; t++) pthread_join(workers[t], NULL);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if (m >= MODE_LUMENLOG) lumenlog_stop();
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+        close(bench.fd);
+
+        long total = bench.events * threads;
+        long lines = m == MODE_LUMENLOG_BINARY ? count_records(bench.path) : count_lines(bench.path);
+        struct stat st;
+        double bytes = stat(bench.path, &st) == 0 ? (double)st.st_size : 0;
+        double ns = elapsed_s(&t0, &t1) * 1e9 / (double)bench.events;  // Per call, per thread
+        if (m == MODE_FOPEN_PER_CALL) base = ns;
+        printf("%-10s %9.0f ns/call  x%-6.1f drain %.1f ms  %.1f bytes/event%s\n", mode_names[m], ns, base / ns,
+               elapsed_s(&t1, &t2) * 1e3, bytes / (double)total, lines == total ? "" : "  LINES MISSING");
+        failed |= lines != total;
+    }
+    unlink(bench.path);
+    return failed;
+}
@@ -0,0 +1,133 @@
+/**
+ * SweetExpRollupDump.c - Dump SweetEngine metric rollups
+ * Reads the mmap-backed rollup rings written by SweetExperiencesEngine.c and
+ * prints count/sum/min/max per bucket for a time range.
+ * Author: Custom Lumen OS Development
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ *
+ * Usage: sweetexp_rollupdump <1m|1h|1d> [metric|all] [from_epoch|-] [to_epoch|-] [data_dir]
+ *        sweetexp_rollupdump --list [data_dir]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sweetexp_abi.h"
+
+// Map a ring read-only; returns the header or NULL
+static const sweetexp_rollup_header* map_ring(const char* dir, const char* resolution, size_t* size) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/sweetexp_rollup_%s.dat", dir, resolution);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "rollupdump: cannot open %s\n", path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(sweetexp_rollup_header)) {
+        close(fd);
+        return NULL;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    const sweetexp_rollup_header* h = map;
+    size_t expected = h->header_size + (size_t)h->slot_count * h->slot_size;
+    if (h->magic != SWEETEXP_ROLLUP_MAGIC || h->version != SWEETEXP_ROLLUP_VERSION ||
+        h->slot_size != sizeof(sweetexp_rollup_slot) || expected > (size_t)st.st_size) {
+        fprintf(stderr, "rollupdump: %s is not a v%d rollup ring\n", path, SWEETEXP_ROLLUP_VERSION);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    *size = st.st_size;
+    return h;
+}
+
+static int find_metric(const sweetexp_rollup_header* h, const char* name) {
+    for (int m = 0; m < SWEETEXP_ROLLUP_METRICS; m++) {
+        if (strncmp(h->metric_names[m], name, SWEETEXP_ROLLUP_NAME_LEN) == 0) return m;
+    }
+    return -1;
+}
+
+// Optional numeric argument; "-" or missing selects the default
+static int64_t arg_epoch(int argc, char** argv, int idx, int64_t fallback) {
+    if (argc <= idx || argv[idx][0] == '\0' || strcmp(argv[idx], "-") == 0) return fallback;
+    return strtoll(argv[idx], NULL, 10);
+}
+
+static void print_bucket(const sweetexp_rollup_header* h, const sweetexp_rollup_slot* slot, int metric) {
+    char when[32];
+    time_t t = (time_t)slot->bucket_start;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+    for (int m = 0; m < SWEETEXP_ROLLUP_METRICS; m++) {
+        const sweetexp_rollup_cell* c = &slot->cells[m];
+        if ((metric >= 0 && m != metric) || c->count == 0) continue;
+        printf("%s %-24.*s count=%llu sum=%lld min=%lld max=%lld\n",
+               when, SWEETEXP_ROLLUP_NAME_LEN, h->metric_names[m],
+               (unsigned long long)c->count, (long long)c->sum,
+               (long long)c->min, (long long)c->max);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "--list") == 0) {
+        size_t size;
+        const sweetexp_rollup_header* h = map_ring(argc > 2 ? argv[2] : SWEETEXP_ROLLUP_DIR, "1m", &size);
+        if (!h) return 1;
+        for (int m = 0; m < SWEETEXP_ROLLUP_METRICS && h->metric_names[m][0]; m++) {
+            printf("%d %.*s\n", m, SWEETEXP_ROLLUP_NAME_LEN, h->metric_names[m]);
+        }
+        return 0;
+    }
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <1m|1h|1d> [metric|all] [from_epoch|-] [to_epoch|-] [data_dir]\n"
+                        "       %s --list [data_dir]\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    const char* dir = argc > 5 ? argv[5] : SWEETEXP_ROLLUP_DIR;
+    size_t size;
+    const sweetexp_rollup_header* h = map_ring(dir, argv[1], &size);
+    if (!h) return 1;
+
+    int metric = -1;
+    if (argc > 2 && strcmp(argv[2], "all") != 0) {
+        metric = find_metric(h, argv[2]);
+        if (metric < 0) {
+            fprintf(stderr, "rollupdump: unknown metric %s\n", argv[2]);
+            return 1;
+        }
+    }
+
+    // Default range is the whole ring ending now; clamp to what the ring can hold
+    int64_t res = h->resolution_sec;
+    int64_t now = (int64_t)time(NULL);
+    int64_t to = arg_epoch(argc, argv, 4, now);
+    int64_t from = arg_epoch(argc, argv, 3, to - res * (h->slot_count - 1));
+    to -= to % res;
+    from -= from % res;
+    if (to - from >= res * (int64_t)h->slot_count) from = to - res * (h->slot_count - 1);
+
+    // Walk buckets in time order; each lookup is one slot index computation
+    const sweetexp_rollup_slot* slots = (const sweetexp_rollup_slot*)((const char*)h + h->header_size);
+    for (int64_t bucket = from; bucket <= to; bucket += res) {
+        const sweetexp_rollup_slot* slot = &slots[(bucket / res) % h->slot_count];
+        if (slot->bucket_start == bucket) print_bucket(h, slot, metric);
+    }
+
+    munmap((void*)h, size);
+    return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * SweetExpSqliteBench.c - Benchmark the SweetEngine SQLite sink write patterns
+ * Writes the same mix of user_achievements upserts and notifications inserts
+ * (the statements from sweetexp_abi.h) into a scratch notif_engine.db three ways:
+ * a connection per row as NotifEngine.java does, one connection committing every
+ * row, and batched transactions on cached statements as the sink does for
+ * user_achievements (notifications are NotifEngine.java's alone).
+ * Author: Custom Lumen OS Development
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ *
+ * Usage: sweetexp_sqlitebench [rows] [batch] [db_path]
+ *        (default 20000 rows, batches of 256, /tmp/sweetexp_sqlitebench.db)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sqlite3.h>
+
+#include "sweetexp_abi.h"
+
+#define BENCH_USERS 64
+#define BENCH_ACHIEVEMENTS 50
+#define BENCH_CONNECTION_ROWS 2000      // The connection-per-row mode is slow; cap its rows
+
+typedef enum {
+    MODE_CONNECTION_PER_ROW,
+    MODE_ROW_AT_A_TIME,
+    MODE_BATCHED
+} BenchMode;
+
+static const char* const mode_names[] = {"connection/row", "row-at-a-time", "batched"};
+
+typedef struct {
+    sqlite3* db;
+    sqlite3_stmt* upsert;
+    sqlite3_stmt* notify;
+} BenchConn;
+
+static double elapsed_s(const struct timespec* a, const struct timespec* b) {
+    return (double)(b->tv_sec - a->tv_sec) + (double)(b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+static int bench_open(BenchConn* c, const char* path, int create) {
+    memset(c, 0, sizeof(*c));
+    if (sqlite3_open_v2(path, &c->db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK ||
+        sqlite3_exec(c->db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", NULL, NULL, NULL) != SQLITE_OK ||
+        (create && sqlite3_exec(c->db, SWEETEXP_SQL_SCHEMA, NULL, NULL, NULL) != SQLITE_OK) ||
+        sqlite3_prepare_v2(c->db, SWEETEXP_SQL_UPSERT_ACHIEVEMENT, -1, &c->upsert, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(c->db, SWEETEXP_SQL_INSERT_NOTIFICATION, -1, &c->notify, NULL) != SQLITE_OK) {
+        fprintf(stderr, "sqlitebench: %s: %s\n", path, c->db ? sqlite3_errmsg(c->db) : "out of memory");
+        return -1;
+    }
+    return 0;
+}
+
+static void bench_close(BenchConn* c) {
+    sqlite3_finalize(c->upsert);
+    sqlite3_finalize(c->notify);
+    sqlite3_close(c->db);
+}
+
+// Row i: three progress upserts for every notification, like an unlock-heavy session
+static int bench_row(BenchConn* c, long i) {
+    char id[32], payload[160];
+    sqlite3_stmt* st;
+    if (i % 4 != 3) {
+        int user = (int)(i % BENCH_USERS);
+        int ach = (int)(i / BENCH_USERS % BENCH_ACHIEVEMENTS);
+        snprintf(id, sizeof(id), "bench_%d", ach);
+        st = c->upsert;
+        sqlite3_bind_int(st, 1, user);
+        sqlite3_bind_text(st, 2, id, -1, SQLITE_STATIC);
+        sqlite3_bind_text(st, 3, "Bench Achievement", -1, SQLITE_STATIC);
+        sqlite3_bind_text(st, 4, "Synthetic progress row", -1, SQLITE_STATIC);
+        sqlite3_bind_int(st, 5, (int)(i % 100));
+        sqlite3_bind_int(st, 6, 100);
+        sqlite3_bind_int(st, 7, i % 100 == 99);
+        sqlite3_bind_int64(st, 8, i % 100 == 99 ? (int64_t)time(NULL) : 0);
+    } else {
+        snprintf(payload, sizeof(payload),
+                 "{\"type\":\"achievement\",\"message\":\"Bench %ld\",\"priority\":5,\"timestamp\":%ld,\"user_id\":%ld}",
+                 i, (long)time(NULL), i % BENCH_USERS);
+        st = c->notify;
+        sqlite3_bind_int(st, 1, (int)(i % BENCH_USERS));
+        sqlite3_bind_text(st, 2, "achievement", -1, SQLITE_STATIC);
+        sqlite3_bind_text(st, 3, "Achievement: Bench", -1, SQLITE_STATIC);
+        sqlite3_bind_text(st, 4, payload, -1, SQLITE_STATIC);
+        sqlite3_bind_text(st, 5, "Bench", -1, SQLITE_STATIC);
+        sqlite3_bind_int(st, 6, 5);
+        sqlite3_bind_int64(st, 7, (int64_t)time(NULL));
+    }
+    int rc = sqlite3_step(st);
+    sqlite3_reset(st);
+    return rc == SQLITE_DONE ? 0 : -1;
+}
+
+static void remove_db(const char* path) {
+    char side[4096];
+    unlink(path);
+    snprintf(side, sizeof(side), "%s-wal", path);
+    unlink(side);
+    snprintf(side, sizeof(side), "%s-shm", path);
+    unlink(side);
+}
+
+// Returns rows per second, or -1
+static double bench_mode(BenchMode mode, const char* path, long rows, int batch) {
+    BenchConn c;
+    remove_db(path);
+    if (bench_open(&c, path, 1) < 0) {
+        bench_close(&c);
+        return -1;
+    }
+
+    struct timespec t0, t1;
+    int failed = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (mode == MODE_CONNECTION_PER_ROW) {
+        bench_close(&c);
+        for (long i = 0; i < rows && !failed; i++) {
+            failed = bench_open(&c, path, 0) < 0 || bench_row(&c, i) < 0;
+            bench_close(&c);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        return failed ? -1 : (double)rows / elapsed_s(&t0, &t1);
+    }
+    for (long i = 0; i < rows && !failed; i++) {
+        if (mode == MODE_BATCHED && i % batch == 0) failed = sqlite3_exec(c.db, "BEGIN IMMEDIATE", NULL, NULL, NULL) != SQLITE_OK;
+        failed |= bench_row(&c, i) < 0;
+        if (mode == MODE_BATCHED && (i % batch == batch - 1 || i == rows - 1)) {
+            failed |= sqlite3_exec(c.db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (failed) fprintf(stderr, "sqlitebench: %s: %s\n", mode_names[mode], sqlite3_errmsg(c.db));
+    bench_close(&c);
+    return failed ? -1 : (double)rows / elapsed_s(&t0, &t1);
+}
+
+int main(int argc, char** argv) {
+    long rows = argc > 1 ? atol(argv[1]) : 20000;
+    int batch = argc > 2 ? atoi(argv[2]) : 256;
+    const char* path = argc > 3 ? argv[3] : "/tmp/sweetexp_sqlitebench.db";
+    if (rows <= 0 || batch <= 0) {
+        fprintf(stderr, "Usage: %s [rows] [batch] [db_path]\n", argv[0]);
+        return 2;
+    }
+
+    printf("rows=%ld batch=%d sqlite=%s\n", rows, batch, sqlite3_libversion());
+    double base = 0;
+    int failed = 0;
+    for (int m = MODE_CONNECTION_PER_ROW; m <= MODE_BATCHED; m++) {
+        long n = m == MODE_CONNECTION_PER_ROW && rows > BENCH_CONNECTION_ROWS ? BENCH_CONNECTION_ROWS : rows;
+        double rate = bench_mode((BenchMode)m, path, n, batch);
+        if (rate < 0) {
+            failed = 1;
+            continue;
+        }
+        if (m == MODE_ROW_AT_A_TIME) base = rate;
+        printf("%-15s %8ld rows %12.0f rows/s", mode_names[m], n, rate);
+        if (base > 0) printf("  x%.1f", rate / base);
+        printf("\n");
+    }
+    remove_db(path);
+    return failed;
+}
@@ -14,36 +14,219 @@
 #include <time.h>
 #include <pthread.h>
 #include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <limits.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include <sys/inotify.h>
+#include <sys/timerfd.h>
+#include <sys/epoll.h>
+#include <dlfcn.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <errno.h>
+#include <libgen.h>
+#ifdef SWEETEXP_SQLITE_SINK
+#include <sqlite3.h>
+#endif
+
+#include "sweetexp_abi.h"
+#include "sweetexp_catalog.h"
+#include "sweetexp_catalog_hash.h"
+#include "sweetexp_eval.h"
+#include "lumenlog.h"
 
 // Configuration paths
 #define SWEETEXP_INI_PATH "/lumen-motonexus6/fw/boot/main/k/sweetexp/sweetexpengine.ini"
 #define SWEETEXP_DATA_PATH "/lumen-motonexus6/fw/boot/main/k/sweetexp/data/sweetexp_enginedata.dat"
+#define SWEETEXP_DATA_DIR "/lumen-motonexus6/fw/boot/main/k/sweetexp/data"
+#define SWEETEXP_TIMERS_PATH "/lumen-motonexus6/fw/boot/main/k/sweetexp/data/sweetexp_timers.dat"
+#define SWEETEXP_JOURNAL_PATH "/lumen-motonexus6/fw/boot/main/k/sweetexp/data/sweetexp_journal.dat"
+#define SWEETEXP_NOTIF_PREFS_PATH "/lumen-motonexus6/fw/boot/main/k/sweetexp/data/sweetexp_notifprefs.dat"
+#define SWEETEXP_ENGINE_LOG_PATH "/lumen-motonexus6/fw/boot/main/k/sweetexp/engine.log"
+#define SWEETEXP_ENGINE_BINLOG_PATH "/lumen-motonexus6/fw/boot/main/k/sweetexp/engine.lbin"
 #define NOTIFENGINE_SOCK "/tmp/notifengine.sock"
+#define SWEETEXP_SUBSCRIBE_SOCK "/tmp/sweetexp_progress.sock"
 
 // Engine constants
 #define MAX_ACHIEVEMENTS 50
 #define MAX_NOTIFICATIONS 100
-#define DATA_BUFFER_SIZE 4096
+#define NOTIF_PAYLOAD_MAX 1024          // One escaped JSON line to NotifEngine
 #define INOTIFY_BUFFER_SIZE 4096
 #define SOCKET_BACKLOG 5
 #define CHECK_INTERVAL_MS 5000
 
-// Achievement structure
+// Timer wheel constants (one tick = one second of wall-clock time)
+#define MAX_SCHEDULED_TIMERS 4096
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_FIRE_BATCH 64
+#define TIMER_ID_INDEX_BITS 16
+
+// Per-user achievement state
+#define MAX_METRICS 32
+#define ACHIEVEMENT_SHARDS 8            // Power of two
+#define MAX_USERS_PER_SHARD 128         // Power of two, open-addressed
+#define SWEET_DEFAULT_USER_ID 0         // 'system' user in notif_engine.db
+#define BATCH_TOUCHED_USERS 16          // Distinct users evaluated together per shard pass
+#define BATCH_UNLOCK_CAPACITY (2 * MAX_ACHIEVEMENTS)
+
+// Activity streaks
+#define ACTIVITY_DAY_WORDS 6            // 384 days
+#define ACTIVITY_HOUR_WORDS 3           // 192 hours
+
+// Leaderboards
+#define RANK_MAX_LEVEL 16               // Plenty for 2^32 users at p = 1/4
+
+// Persistence
+#define SAVE_GROUP_WINDOW_MS 10         // Saves requested this close together share one commit
+#define JOURNAL_BUFFER_SIZE 65536
+#define JOURNAL_CHECKPOINT_BYTES (4 << 20)  // Checkpoint once the journal grows past this
+#define JOURNAL_CHECKPOINT_CHECKS 720   // ...or every 720 checks (~1h) while state is dirty
+#define PERSIST_SYNC 1                  // Persistence writer requests
+#define PERSIST_CHECKPOINT 2
+#define PERSIST_ANNOUNCE_QUEUE 1024     // Unlocks waiting for the writer's journal sync
+
+// Engine log
+#define ENGINE_LOG_TAG "SweetEngine"    // Tag on every line in engine.log
+
+// SQLite sink
+#define SQLITE_SINK_MAX_ROWS 4096       // Pending achievement upserts; more force a resync
+#define SQLITE_SINK_BATCH 256           // Flush once this many rows are pending...
+#define SQLITE_SINK_FLUSH_MS 250        // ...or this long after the first one
+#define SQLITE_SINK_BUSY_MS 2000        // How long to wait out NotifEngine's write lock
+
+// Notification routing filters
+#define MAX_NOTIF_FILTERS 1024          // Power of two, open-addressed
+#define NOTIF_MAX_QUIET 8               // Quiet intervals per user after splitting at midnight
+#define NOTIF_QUIET_BREAKTHROUGH 5      // Priorities from here ignore quiet hours
+
+// Notification digests
+#define MAX_NOTIF_DIGESTS 64            // Pending (user, type) digests
+#define DIGEST_MAX_PRIORITY 2           // Higher priorities are always sent at once
+#define DIGEST_SAMPLES 4                // Distinct messages quoted in a summary
+#define DIGEST_SAMPLE_LEN 64
+
+// History backfill
+#define BACKFILL_DEFAULT_DAYS SWEETEXP_HIST_RETENTION_DAYS
+#define BACKFILL_MAX_WORKERS 32
+#define BACKFILL_CHUNKS_PER_WORKER 4    // Work items per worker, for load balance
+
+// /proc sampler
+#define PROC_SAMPLE_DEFAULT_MS 1000
+#define PROC_SAMPLE_MIN_MS 50
+#define PROC_SAMPLE_BUFFER 16384        // /proc/stat grows with the CPU count
+
+// Event provider plugins
+#define MAX_PLUGINS 8
+
+// Event ingestion socket
+#define MAX_INGEST_CLIENTS 64
+#define INGEST_CLIENT_BUFFER 16384      // Must hold one full frame (8 KiB + header)
+#define INGEST_BATCH 1024               // Events handed to submit_metric_batch at once
+
+// Progress subscription constants
+#define MAX_SUBSCRIBERS 64
+#define SUBSCRIPTION_DEFAULT_MAX_HZ 10
+#define SUBSCRIPTION_MAX_HZ_LIMIT 60
+
+// Achievement structure (strings point into the built-in catalogue or are strdup'ed
+// from ACH: lines for custom achievements)
 typedef struct {
-    char id[32];
-    char name[64];
-    char description[128];
+    const char* id;
+    const char* name;
+    const char* description;
     int progress;
     int target;
     int unlocked;
     time_t unlock_time;
+    int metric;     // Metric whose value drives progress, -1 if manual only
+    int kind;       // AchievementKind: what `target` counts on that metric
 } Achievement;
 
+// Progress is the metric total, or a query over its activity bitmaps
+typedef enum {
+    ACHIEVEMENT_TOTAL = 0,
+    ACHIEVEMENT_DAILY_STREAK,
+    ACHIEVEMENT_HOURLY_STREAK,
+    ACHIEVEMENT_BEST_DAILY_STREAK,  // Longest run of active days in the last year
+    ACHIEVEMENT_ACTIVE_DAYS_30      // Active days among the last 30
+} AchievementKind;
+
+// Built-in metric identifiers (further metrics are registered at runtime)
+typedef enum {
+    METRIC_BOOT_COUNT = SWEETEXP_METRIC_BOOT_COUNT,         // Ids are part of the ingest ABI
+    METRIC_WAYLAND_EVENTS = SWEETEXP_METRIC_WAYLAND_EVENTS,
+    METRIC_NOTIFICATIONS_SENT = SWEETEXP_METRIC_NOTIFICATIONS_SENT,
+    METRIC_NOTIFICATIONS_DROPPED = SWEETEXP_METRIC_NOTIFICATIONS_DROPPED,
+    METRIC_BUILTIN_COUNT
+} MetricId;
+
+// One user's progress on one achievement (mirrors a user_achievements row)
+typedef struct {
+    int progress;
+    int unlocked;
+    time_t unlock_time;
+    int shm_slot;   // 1-based slot in the shared progress snapshot, 0 unpublished, -1 table full
+} AchievementProgress;
+
+// Activity bitmaps for one metric: bit 0 is the most recent active day/hour, bit k
+// the one k units earlier. A year of days is 48 bytes, eight days of hours 24.
+typedef struct {
+    int32_t last_day;               // Unix day of bit 0, 0 = never active
+    int32_t last_hour;              // Unix hour of bit 0
+    uint64_t days[ACTIVITY_DAY_WORDS];
+    uint64_t hours[ACTIVITY_HOUR_WORDS];
+} ActivityBitmap;
+
+// Skip list node ranking one user on one metric (see LEADERBOARDS)
+typedef struct RankNode {
+    int64_t score;
+    int user_id;
+    int level;
+    struct {
+        struct RankNode* next;
+        uint32_t span;              // Ranks skipped by following `next`
+    } links[];
+} RankNode;
+
+// Per-user state, owned by exactly one shard
+typedef struct {
+    int user_id;
+    int dirty;
+    uint64_t version;               // Bumped on every change; lets readers skip unchanged users
+    int64_t metrics[MAX_METRICS];
+    AchievementProgress progress[MAX_ACHIEVEMENTS];
+    ActivityBitmap activity[MAX_METRICS];
+    RankNode* rank_nodes[MAX_METRICS];  // Leaderboard entries, NULL until first ranked
+} UserAchievementState;
+
+// Unlock found while a shard lock is held, announced after it is released
+typedef struct {
+    int user_id;
+    int achievement;
+    time_t unlock_time;             // As stored in the user's progress
+} PendingUnlock;
+
+// (user, metrics bitmask) touched during one shard pass of a batch
+typedef struct {
+    UserAchievementState* user;
+    uint32_t metrics;
+} BatchTouched;
+
+// Partition of users with its own lock and dirty tracking
+typedef struct {
+    pthread_mutex_t lock;
+    int user_count;
+    int dirty_users;
+    UserAchievementState* users[MAX_USERS_PER_SHARD];
+    sweetexp_rollup_cell rollup_pending[MAX_METRICS];  // Samples since the last rollup flush
+} __attribute__((aligned(64))) AchievementShard;
+
 // Notification structure
 typedef struct {
     char message[256];
@@ -58,21 +241,155 @@ typedef struct {
     pthread_mutex_t data_mutex;
     pthread_t achievement_thread;
     pthread_t notification_thread;
-    pthread_t wayland_listener;
-    pthread_t kernel_hook;
+    pthread_t ingest_thread;
+    pthread_t proc_sampler;
+    pthread_t timer_thread;
+    pthread_t subscription_thread;
+    pthread_t persist_thread;
     int data_fd;
     int notif_sock;
-    Achievement achievements[MAX_ACHIEVEMENTS];
+    Achievement achievements[MAX_ACHIEVEMENTS];  // Definitions; progress lives in shards
     int achievement_count;
+    AchievementShard shards[ACHIEVEMENT_SHARDS];
+    int metric_achievements[MAX_METRICS][MAX_ACHIEVEMENTS];  // Achievements bound to each metric
+    int metric_achievement_count[MAX_METRICS];
+    int64_t achievement_targets[MAX_ACHIEVEMENTS] __attribute__((aligned(32)));  // Contiguous copy for batch evaluation
     Notification notification_queue[MAX_NOTIFICATIONS];
     int notification_count;
     int notification_head;
     int notification_tail;
+    int subscription_max_hz;        // SUBSCRIPTION_MAX_HZ in sweetexpengine.ini
+    int proc_sample_ms;             // PROC_SAMPLE_MS in sweetexpengine.ini
+    char plugin_paths[MAX_PLUGINS][256];  // PLUGIN= lines in sweetexpengine.ini
+    int plugin_path_count;
+    char sqlite_sink_path[256];     // SQLITE_SINK in sweetexpengine.ini, empty = off
+    int log_binary;                 // LOG_FORMAT=binary in sweetexpengine.ini
+    pthread_t sqlite_thread;
 } SweetEngine;
 
+// Scheduled notification (node in the timer wheel)
+typedef struct ScheduledTimer {
+    struct ScheduledTimer* next;
+    struct ScheduledTimer** pprev;  // Points at the slot head or previous next, for O(1) unlink
+    uint64_t expires;               // Wall-clock second the notification is due
+    uint32_t generation;            // Bumped on every reuse so stale ids cannot cancel
+    uint8_t level;
+    uint8_t slot;
+    uint8_t active;
+    Notification notif;
+} ScheduledTimer;
+
+// Hierarchical timing wheel driven by a single timerfd
+typedef struct {
+    pthread_mutex_t lock;
+    int timer_fd;
+    int persist_fd;
+    uint64_t now;                   // Next tick to be processed
+    uint64_t armed;                 // Tick the timerfd is armed for, 0 if disarmed
+    ScheduledTimer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint64_t occupied[TIMER_WHEEL_LEVELS];  // One bit per non-empty slot
+    ScheduledTimer pool[MAX_SCHEDULED_TIMERS];
+    ScheduledTimer* free_list;
+    int pending;
+    int log_records;                // Records in the persist file since last compaction
+} TimerWheel;
+
+// On-disk timer record (append-only log, compacted at startup)
+typedef struct {
+    uint32_t op;                    // TIMER_REC_ADD or TIMER_REC_DEL
+    uint32_t reserved;
+    int64_t timer_id;
+    int64_t deliver_at;
+    Notification notif;
+} TimerRecord;
+
+#define TIMER_REC_ADD 1
+#define TIMER_REC_DEL 2
+
 // Global engine instance
 SweetEngine engine = {0};
 
+// Built-in achievements occupy engine.achievements[0..BUILTIN_ACHIEVEMENT_COUNT) in
+// catalogue order; the table lives in .rodata and is never written
+#define BUILTIN_ACHIEVEMENT(id, name, description, target, metric, kind) \
+    {#id, name, description, 0, target, 0, 0, SWEETEXP_METRIC_##metric, ACHIEVEMENT_##kind},
+static const Achievement builtin_achievements[] = {
+    SWEETEXP_BUILTIN_ACHIEVEMENTS(BUILTIN_ACHIEVEMENT)
+};
+#undef BUILTIN_ACHIEVEMENT
+
+#define BUILTIN_ACHIEVEMENT_COUNT ((int)(sizeof(builtin_achievements) / sizeof(builtin_achievements[0])))
+
+_Static_assert(BUILTIN_ACHIEVEMENT_COUNT == SWEETEXP_CATALOG_HASH_COUNT,
+               "sweetexp_catalog.h changed: regenerate sweetexp_catalog_hash.h");
+_Static_assert(BUILTIN_ACHIEVEMENT_COUNT <= MAX_ACHIEVEMENTS, "too many built-in achievements");
+
+static int builtin_achievement_hashed(const char* id) {
+    uint32_t bucket = sweetexp_catalog_hash(id, 0) % SWEETEXP_CATALOG_HASH_COUNT;
+    uint32_t slot = sweetexp_catalog_hash(id, sweetexp_catalog_displace[bucket]) % SWEETEXP_CATALOG_HASH_COUNT;
+    int idx = sweetexp_catalog_slot[slot];
+    return strcmp(builtin_achievements[idx].id, id) == 0 ? idx : -1;
+}
+
+// The count assert above cannot see a renamed id, so check once that every
+// built-in hashes to itself; 1 if the generated table matches the catalogue
+static int builtin_hash_current(void) {
+    static int state;  // 0 unchecked, 1 current, 2 stale
+    int s = __atomic_load_n(&state, __ATOMIC_RELAXED);
+    if (s == 0) {
+        s = 1;
+        for (int i = 0; i < BUILTIN_ACHIEVEMENT_COUNT; i++) {
+            if (builtin_achievement_hashed(builtin_achievements[i].id) != i) s = 2;
+        }
+        if (s == 2 && __atomic_exchange_n(&state, s, __ATOMIC_RELAXED) != 2) {
+            fprintf(stderr, "SweetEngine: sweetexp_catalog_hash.h is stale, using linear catalogue lookup\n");
+        }
+        __atomic_store_n(&state, s, __ATOMIC_RELAXED);
+    }
+    return s == 1;
+}
+
+// Catalogue index of a built-in id via the generated perfect hash, -1 if not built in
+static int builtin_achievement_index(const char* id) {
+    if (builtin_hash_current()) return builtin_achievement_hashed(id);
+    for (int i = 0; i < BUILTIN_ACHIEVEMENT_COUNT; i++) {
+        if (strcmp(builtin_achievements[i].id, id) == 0) return i;
+    }
+    return -1;
+}
+static TimerWheel timer_wheel;
+
+// Metric registry
+static const char* metric_names[MAX_METRICS] = {
+    "boot_count", "wayland_events", "notifications_sent", "notifications_dropped"
+};
+static int metric_count = METRIC_BUILTIN_COUNT;
+static uint32_t metric_gauges;      // Bit m: metric m holds the latest sample, not a total
+static pthread_mutex_t metric_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Metric rollup rings (per-minute, per-hour, per-day)
+typedef struct {
+    const char* file;
+    uint32_t resolution_sec;
+    uint32_t slot_count;
+    sweetexp_rollup_header* header;
+    sweetexp_rollup_slot* slots;
+    size_t map_size;
+} RollupRing;
+
+static RollupRing rollup_rings[] = {
+    {"sweetexp_rollup_1m.dat", 60, 1440, NULL, NULL, 0},        // 24 hours
+    {"sweetexp_rollup_1h.dat", 3600, 720, NULL, NULL, 0},       // 30 days
+    {"sweetexp_rollup_1d.dat", 86400, 730, NULL, NULL, 0},      // 2 years
+};
+#define ROLLUP_RING_COUNT ((int)(sizeof(rollup_rings) / sizeof(rollup_rings[0])))
+
+static sweetexp_rollup_cell rollup_global_pending[MAX_METRICS];
+static pthread_mutex_t rollup_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Shared-memory progress snapshot for GUI readers (NULL if unavailable)
+static sweetexp_shm_table* progress_shm = NULL;
+
 // Forward declarations
 int load_config(void);
 int save_engine_data(void);
@@ -80,39 +397,126 @@ int load_engine_data(void);
 void init_directories(void);
 int connect_notif_engine(void);
 int send_notification(const char* message, const char* type, int priority);
+int send_user_notification(int user_id, const char* message, const char* type, int priority);
+int notification_allowed(int user_id, const char* type, int priority);
+int refresh_notification_filters(void);
+int configure_notification_digest(const char* spec);
+int notification_digest_add(int user_id, const char* message, const char* type, int priority);
+void flush_notification_digests(int force);
 void generate_random_notification(void);
 void check_achievement_progress(void);
 void* achievement_monitor_thread(void* arg);
 void* notification_dispatcher_thread(void* arg);
-void* wayland_event_listener(void* arg);
-void* kernel_hook_listener(void* arg);
+void* proc_sampler_thread(void* arg);
+void init_proc_metrics(void);
 void signal_handler(int sig);
 void unlock_achievement(const char* id);
+void init_achievement_shards(void);
+int register_metric(const char* name);
+int register_gauge_metric(const char* name);
+int lookup_metric(const char* name);
+int submit_metric_event(int user_id, int metric_id, int64_t delta);
+int submit_metric_batch(const sweetexp_event* events, uint32_t count);
+int unlock_user_achievement(int user_id, const char* id);
+void rebuild_metric_index(void);
+int init_progress_snapshot(void);
+int init_metric_rollups(void);
+void record_metric_sample(int metric_id, int64_t value);
+void flush_metric_rollups(void);
 void log_engine_event(const char* event);
+void log_engine_event_format(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+// Pasting "" onto fmt rejects anything but a string literal at compile time
+#define log_engine_eventf(fmt, ...) log_engine_event_format("" fmt, ##__VA_ARGS__)
+void init_engine_logger(void);
+int start_engine_logger(void);
+void stop_engine_logger(void);
+int init_timer_wheel(void);
+int64_t schedule_notification_at(time_t deliver_at, const char* message, const char* type, int priority);
+int64_t schedule_notification_in(unsigned int delay_sec, const char* message, const char* type, int priority);
+int cancel_scheduled_notification(int64_t timer_id);
+void* timer_wheel_thread(void* arg);
+void wake_timer_wheel(void);
+void* subscription_server_thread(void* arg);
+void* ingest_server_thread(void* arg);
+int load_plugins(void);
+void unload_plugins(void);
+void init_leaderboards(void);
+int leaderboard_top(int metric_id, uint32_t offset, sweetexp_rank_entry* out, int max, uint32_t* total);
+int leaderboard_rank(int metric_id, int user_id, sweetexp_rank_entry* out, uint32_t* total);
+int reevaluate_all_achievements(void);
+int backfill_history(int days, int workers);
+int define_achievement(const char* id, const char* name, const char* description, int target, int metric_id, int kind);
+int start_persist_writer(void);
+void stop_persist_writer(void);
+int start_sqlite_sink(void);
+void stop_sqlite_sink(void);
+int journal_open(void);
+void journal_record_metric(int user_id, int metric_id, int64_t value, int64_t active_at);
+void journal_record_unlock(int user_id, const char* id, time_t unlock_time);
+int journal_sync(void);
+uint64_t journal_size(void);
+
+// Apply one KEY=VALUE setting from sweetexpengine.ini
+static void apply_config_value(const char* key, const char* value) {
+    if (strcmp(key, "SUBSCRIPTION_MAX_HZ") == 0) {
+        engine.subscription_max_hz = atoi(value);
+    } else if (strcmp(key, "PROC_SAMPLE_MS") == 0) {
+        engine.proc_sample_ms = atoi(value);
+    } else if (strcmp(key, "DIGEST") == 0) {
+        configure_notification_digest(value);
+    } else if (strcmp(key, "SQLITE_SINK") == 0) {
+        // "1" = the standard NotifEngine database, "0" or empty = off, else a path
+        const char* path = strcmp(value, "1") == 0 ? SWEETEXP_NOTIF_DB_PATH : strcmp(value, "0") == 0 ? "" : value;
+        snprintf(engine.sqlite_sink_path, sizeof(engine.sqlite_sink_path), "%s", path);
+    } else if (strcmp(key, "LOG_OVERFLOW") == 0) {
+        lumenlog_set_overflow(strcmp(value, "block") == 0 ? LUMENLOG_OVERFLOW_BLOCK
+                              : strcmp(value, "sync") == 0  ? LUMENLOG_OVERFLOW_SYNC
+                                                            : LUMENLOG_OVERFLOW_DROP);
+    } else if (strcmp(key, "LOG_FORMAT") == 0) {
+        engine.log_binary = strcmp(value, "binary") == 0;  // Read at startup only
+    } else if (strcmp(key, "PLUGIN") == 0 && value[0]) {
+        for (int i = 0; i < engine.plugin_path_count; i++) {
+            if (strcmp(engine.plugin_paths[i], value) == 0) return;
+        }
+        if (engine.plugin_path_count < MAX_PLUGINS) {
+            strncpy(engine.plugin_paths[engine.plugin_path_count], value, sizeof(engine.plugin_paths[0]) - 1);
+            engine.plugin_path_count++;
+        }
+    }
+}
 
-// Parse INI file for SWEETENGINE key
+// Parse INI file for SWEETENGINE key and engine settings
 int load_config(void) {
     FILE* fp = fopen(SWEETEXP_INI_PATH, "r");
     if (!fp) {
-        fprintf(stderr, "SweetEngine: Config file not found, defaulting to disabled
-");
+        fprintf(stderr, "SweetEngine: Config file not found, defaulting to disabled\n");
         return 0;
     }
 
     char line[256];
+    int enabled = 0;
     while (fgets(line, sizeof(line), fp)) {
         if (strstr(line, "SWEETENGINE=true")) {
-            engine.enabled = 1;
-            fclose(fp);
-            printf("SweetEngine: Enabled via config
-");
-            return 1;
+            enabled = 1;
+            continue;
         }
+        char* eq = strchr(line, '=');
+        if (!eq || line[0] == '#' || line[0] == ';' || line[0] == '[') continue;
+        *eq = '\0';
+        char* key = line + strspn(line, " \t");
+        key[strcspn(key, " \t")] = '\0';
+        char* value = eq + 1 + strspn(eq + 1, " \t");
+        value[strcspn(value, " \t\r\n")] = '\0';
+        apply_config_value(key, value);
     }
     
     fclose(fp);
-    printf("SweetEngine: Disabled via config
-");
+    if (enabled) {
+        engine.enabled = 1;
+        printf("SweetEngine: Enabled via config\n");
+        return 1;
+    }
+    printf("SweetEngine: Disabled via config\n");
     return 0;
 }
 
@@ -147,24 +551,79 @@ int connect_notif_engine(void) {
     return sock;
 }
 
-// Send notification to NotifEngine.java
+static int deliver_notification(int user_id, const char* message, const char* type, int priority);
+
+// Send notification to NotifEngine.java on behalf of the system user
 int send_notification(const char* message, const char* type, int priority) {
+    return send_user_notification(SWEET_DEFAULT_USER_ID, message, type, priority);
+}
+
+// Send a notification for `user_id` unless their preferences filter it out
+int send_user_notification(int user_id, const char* message, const char* type, int priority) {
+    if (!notification_allowed(user_id, type, priority)) return 0;
+    if (notification_digest_add(user_id, message, type, priority)) return 0;
+    return deliver_notification(user_id, message, type, priority);
+}
+
+// Copy `in` into `out` as the body of a JSON string: quote, backslash and control
+// characters are escaped, UTF-8 passes through. Stops before an escape that would
+// not fit; returns the length written.
+static size_t json_escape(char* out, size_t size, const char* in) {
+    size_t len = 0;
+    for (; *in; in++) {
+        unsigned char c = (unsigned char)*in;
+        char esc[8];
+        size_t n = 2;
+        esc[0] = '\\';
+        if (c == '"' || c == '\\') esc[1] = (char)c;
+        else if (c == '\n') esc[1] = 'n';
+        else if (c == '\r') esc[1] = 'r';
+        else if (c == '\t') esc[1] = 't';
+        else if (c < 0x20) n = (size_t)snprintf(esc, sizeof(esc), "\\u%04x", c);
+        else {
+            esc[0] = (char)c;
+            n = 1;
+        }
+        if (len + n >= size) break;
+        memcpy(out + len, esc, n);
+        len += n;
+    }
+    if (size > 0) out[len] = '\0';
+    return len;
+}
+
+// The JSON line NotifEngine receives (and stores as raw_json_payload). NotifEngine
+// reads one object per line, so message and type are escaped; the escaped fields
+// are bounded so the closing "}\n" always fits in NOTIF_PAYLOAD_MAX.
+static void format_notification_payload(char* buffer, size_t size, int user_id, const char* message,
+                                        const char* type, int priority, time_t now) {
+    char esc_message[NOTIF_PAYLOAD_MAX - 256];
+    char esc_type[64];
+    json_escape(esc_message, sizeof(esc_message), message);
+    json_escape(esc_type, sizeof(esc_type), type);
+    snprintf(buffer, size, 
+             "{\"type\":\"%s\",\"message\":\"%s\",\"priority\":%d,\"timestamp\":%ld,\"user_id\":%d}\n",
+             esc_type, esc_message, priority, (long)now, user_id);
+}
+
+// Write one notification to NotifEngine, bypassing filters and digests
+static int deliver_notification(int user_id, const char* message, const char* type, int priority) {
+    char buffer[NOTIF_PAYLOAD_MAX];
+    time_t now = time(NULL);
+    format_notification_payload(buffer, sizeof(buffer), user_id, message, type, priority, now);
+
     int sock = connect_notif_engine();
     if (sock < 0) {
-        fprintf(stderr, "SweetEngine: Failed to connect to NotifEngine
-");
+        fprintf(stderr, "SweetEngine: Failed to connect to NotifEngine\n");
+        record_metric_sample(METRIC_NOTIFICATIONS_DROPPED, 1);
         return -1;
     }
     
-    char buffer[512];
-    time_t now = time(NULL);
-    snprintf(buffer, sizeof(buffer), 
-             "{"type":"%s","message":"%s","priority":%d,"timestamp":%ld}
-",
-             type, message, priority, now);
-    
     write(sock, buffer, strlen(buffer));
     close(sock);
+    // Per user, like backfill's replay of the history NotifEngine keeps; this also
+    // feeds the rollups
+    submit_metric_event(user_id, METRIC_NOTIFICATIONS_SENT, 1);
     return 0;
 }
 
@@ -189,62 +648,712 @@ void generate_random_notification(void) {
 
 // Check achievement progress and unlock
 void check_achievement_progress(void) {
-    // Example achievements - extend with kernel/Wayland metrics
-    static int boot_count = 0;
-    static int wayland_events = 0;
-    
-    // Simulate boot count achievement
-    boot_count++;
-    for (int i = 0; i < engine.achievement_count; i++) {
-        if (strcmp(engine.achievements[i].id, "boot_master") == 0 &&
-            boot_count >= engine.achievements[i].target &&
-            !engine.achievements[i].unlocked) {
-            unlock_achievement("boot_master");
+    // Boot heartbeat for the default user - extend with kernel/Wayland metrics
+    submit_metric_event(SWEET_DEFAULT_USER_ID, METRIC_BOOT_COUNT, 1);
+}
+
+// Announce an unlock (called with no shard lock held); the caller persists
+static void announce_unlock(int user_id, const Achievement* ach) {
+    char msg[256];
+    snprintf(msg, sizeof(msg), "🏆 Achievement Unlocked: %s! %s", ach->name, ach->description);
+
+    send_user_notification(user_id, msg, "achievement", 5);
+    log_engine_eventf("Achievement unlocked: %s (user %d)", ach->id, user_id);
+}
+
+// Unlock achievement for the default user and notify
+void unlock_achievement(const char* id) {
+    unlock_user_achievement(SWEET_DEFAULT_USER_ID, id);
+}
+
+// ==================== METRIC ROLLUPS ====================
+// Every metric sample is folded into count/sum/min/max cells. Hot paths only touch
+// an in-memory pending cell (per shard, under the shard lock they already hold, or
+// the global one for engine-wide counters); the monitor thread merges pending cells
+// into three fixed-size, mmap-backed rings under SWEETEXP_DATA_DIR every check
+// interval. A ring slot is reused once its bucket ages out, so appends are O(1),
+// nothing is allocated per sample, and disk use is fixed at creation time.
+// Layout is in sweetexp_abi.h; SweetExpRollupDump reads the same files.
+
+_Static_assert(MAX_METRICS == SWEETEXP_ROLLUP_METRICS, "rollup rings hold one cell per metric");
+
+static inline void rollup_cell_add(sweetexp_rollup_cell* cell, int64_t value) {
+    if (cell->count == 0 || value < cell->min) cell->min = value;
+    if (cell->count == 0 || value > cell->max) cell->max = value;
+    cell->count++;
+    cell->sum += value;
+}
+
+static inline void rollup_cell_merge(sweetexp_rollup_cell* dst, const sweetexp_rollup_cell* src) {
+    if (src->count == 0) return;
+    if (dst->count == 0 || src->min < dst->min) dst->min = src->min;
+    if (dst->count == 0 || src->max > dst->max) dst->max = src->max;
+    dst->count += src->count;
+    dst->sum += src->sum;
+}
+
+// Map one ring file, creating or resetting it when the layout does not match
+static int rollup_open_ring(RollupRing* ring) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", SWEETEXP_DATA_DIR, ring->file);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+
+    size_t size = sizeof(sweetexp_rollup_header) + (size_t)ring->slot_count * sizeof(sweetexp_rollup_slot);
+    struct stat st;
+    int fresh = fstat(fd, &st) < 0 || (size_t)st.st_size != size;
+    if (fresh && ftruncate(fd, 0) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)size) < 0) {
+        close(fd);
+        return -1;
+    }
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    sweetexp_rollup_header* h = map;
+    if (!fresh) {
+        fresh = h->magic != SWEETEXP_ROLLUP_MAGIC || h->version != SWEETEXP_ROLLUP_VERSION ||
+                h->resolution_sec != ring->resolution_sec || h->slot_count != ring->slot_count;
+        for (int m = 0; m < METRIC_BUILTIN_COUNT && !fresh; m++) {
+            fresh = strncmp(h->metric_names[m], metric_names[m], SWEETEXP_ROLLUP_NAME_LEN) != 0;
         }
     }
-    
-    // Wayland event achievement (tracked by listener)
-    for (int i = 0; i < engine.achievement_count; i++) {
-        if (strcmp(engine.achievements[i].id, "wayland_pro") == 0 &&
-            wayland_events >= engine.achievements[i].target &&
-            !engine.achievements[i].unlocked) {
-            unlock_achievement("wayland_pro");
+    if (fresh) {
+        memset(map, 0, size);
+        h->magic = SWEETEXP_ROLLUP_MAGIC;
+        h->version = SWEETEXP_ROLLUP_VERSION;
+        h->resolution_sec = ring->resolution_sec;
+        h->slot_count = ring->slot_count;
+        h->metric_capacity = SWEETEXP_ROLLUP_METRICS;
+        h->header_size = sizeof(sweetexp_rollup_header);
+        h->slot_size = sizeof(sweetexp_rollup_slot);
+    }
+
+    ring->header = h;
+    ring->slots = (sweetexp_rollup_slot*)((char*)map + sizeof(sweetexp_rollup_header));
+    ring->map_size = size;
+    return 0;
+}
+
+// Map all rings; re-registers recorded metric names so history keeps its ids
+int init_metric_rollups(void) {
+    int ok = 0;
+    for (int r = 0; r < ROLLUP_RING_COUNT; r++) {
+        if (rollup_open_ring(&rollup_rings[r]) == 0) ok++;
+    }
+    for (int r = 0; r < ROLLUP_RING_COUNT; r++) {
+        sweetexp_rollup_header* h = rollup_rings[r].header;
+        if (!h) continue;
+        for (int m = METRIC_BUILTIN_COUNT; m < SWEETEXP_ROLLUP_METRICS && h->metric_names[m][0]; m++) {
+            char name[SWEETEXP_ROLLUP_NAME_LEN + 1];
+            memcpy(name, h->metric_names[m], SWEETEXP_ROLLUP_NAME_LEN);
+            name[SWEETEXP_ROLLUP_NAME_LEN] = '\0';
+            if (register_metric(name) != m) break;
         }
     }
+    return ok == ROLLUP_RING_COUNT ? 0 : -1;
 }
 
-// Unlock achievement and notify
-void unlock_achievement(const char* id) {
+// Record an engine-wide sample (metrics not tied to a user)
+void record_metric_sample(int metric_id, int64_t value) {
+    if (metric_id < 0 || metric_id >= MAX_METRICS) return;
+    pthread_mutex_lock(&rollup_lock);
+    rollup_cell_add(&rollup_global_pending[metric_id], value);
+    pthread_mutex_unlock(&rollup_lock);
+}
+
+// Slot for the bucket containing `now`, recycled if it still holds an older bucket
+static sweetexp_rollup_slot* rollup_current_slot(RollupRing* ring, time_t now) {
+    int64_t bucket = (int64_t)now - (int64_t)now % ring->resolution_sec;
+    sweetexp_rollup_slot* slot = &ring->slots[(bucket / ring->resolution_sec) % ring->slot_count];
+    if (slot->bucket_start != bucket) {
+        memset(slot->cells, 0, sizeof(slot->cells));
+        slot->bucket_start = bucket;
+    }
+    return slot;
+}
+
+// Merge all pending samples into the rings (monitor thread)
+void flush_metric_rollups(void) {
+    sweetexp_rollup_cell merged[MAX_METRICS];
+    memset(merged, 0, sizeof(merged));
+
+    for (int s = 0; s < ACHIEVEMENT_SHARDS; s++) {
+        AchievementShard* shard = &engine.shards[s];
+        pthread_mutex_lock(&shard->lock);
+        for (int m = 0; m < MAX_METRICS; m++) rollup_cell_merge(&merged[m], &shard->rollup_pending[m]);
+        memset(shard->rollup_pending, 0, sizeof(shard->rollup_pending));
+        pthread_mutex_unlock(&shard->lock);
+    }
+
+    pthread_mutex_lock(&rollup_lock);
+    for (int m = 0; m < MAX_METRICS; m++) rollup_cell_merge(&merged[m], &rollup_global_pending[m]);
+    memset(rollup_global_pending, 0, sizeof(rollup_global_pending));
+
+    time_t now = time(NULL);
+    int count = metric_count;
+    for (int r = 0; r < ROLLUP_RING_COUNT; r++) {
+        RollupRing* ring = &rollup_rings[r];
+        if (!ring->header) continue;
+        for (int m = 0; m < count; m++) {
+            if (!ring->header->metric_names[m][0]) {
+                strncpy(ring->header->metric_names[m], metric_names[m], SWEETEXP_ROLLUP_NAME_LEN - 1);
+            }
+        }
+        sweetexp_rollup_slot* slot = rollup_current_slot(ring, now);
+        for (int m = 0; m < count; m++) rollup_cell_merge(&slot->cells[m], &merged[m]);
+    }
+    pthread_mutex_unlock(&rollup_lock);
+}
+
+// ==================== SHARED PROGRESS SNAPSHOT ====================
+// Publishes every user's achievement progress into a fixed-layout table in
+// /dev/shm (see sweetexp_abi.h) so LUMENGUI components can read current state
+// without IPC. Each entry has its own seqlock; entries are only ever written
+// under the owning user's shard lock, so there is exactly one writer per entry
+// and an update costs two plain stores around the final store-release of `seq`.
+
+int init_progress_snapshot(void) {
+    int fd = shm_open(SWEETEXP_SHM_NAME, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "SweetEngine: shm_open failed: %s\n", strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(sweetexp_shm_table)) < 0) {
+        close(fd);
+        return -1;
+    }
+    void* map = mmap(NULL, sizeof(sweetexp_shm_table), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    sweetexp_shm_table* table = map;
+    sweetexp_shm_header* h = &table->header;
+    uint32_t epoch = h->magic == SWEETEXP_SHM_MAGIC ? h->epoch + 1 : 1;
+
+    // Readers still mapped from a previous run see magic 0 / unpublished slots while we reset
+    __atomic_store_n(&h->magic, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->entry_count, 0, __ATOMIC_RELEASE);
+    memset(table->entries, 0, sizeof(table->entries));
+    h->version = SWEETEXP_SHM_VERSION;
+    h->header_size = sizeof(sweetexp_shm_header);
+    h->entry_size = sizeof(sweetexp_shm_entry);
+    h->capacity = SWEETEXP_SHM_MAX_ENTRIES;
+    h->writer_pid = (uint32_t)getpid();
+    __atomic_store_n(&h->epoch, epoch, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->magic, SWEETEXP_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    progress_shm = table;
+    return 0;
+}
+
+static void sqlite_sink_progress_locked(int user_id, int idx, const AchievementProgress* p);
+
+// Publish one user's progress on one achievement to the shared snapshot and the
+// SQLite sink (caller holds the user's shard lock)
+static void publish_progress_locked(const UserAchievementState* user, AchievementProgress* p, int idx) {
+    sqlite_sink_progress_locked(user->user_id, idx, p);
+    if (!progress_shm || p->shm_slot < 0) return;
+
+    sweetexp_shm_entry* e;
+    uint32_t seq;
+    if (p->shm_slot == 0) {
+        uint32_t slot = __atomic_fetch_add(&progress_shm->header.entry_count, 1, __ATOMIC_RELAXED);
+        if (slot >= SWEETEXP_SHM_MAX_ENTRIES) {
+            p->shm_slot = -1;
+            return;
+        }
+        p->shm_slot = (int)slot + 1;
+        e = &progress_shm->entries[slot];
+        seq = 0;
+        __atomic_store_n(&e->seq, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        e->user_id = user->user_id;
+        e->metric = engine.achievements[idx].metric;
+        strncpy(e->achievement_id, engine.achievements[idx].id, sizeof(e->achievement_id) - 1);
+    } else {
+        e = &progress_shm->entries[p->shm_slot - 1];
+        seq = e->seq;
+        __atomic_store_n(&e->seq, seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    __atomic_store_n(&e->progress, p->progress, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->target, engine.achievements[idx].target, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->unlocked, (uint32_t)p->unlocked, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->unlock_time, (int64_t)p->unlock_time, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// ==================== ACTIVITY STREAKS ====================
+// Every positive metric event sets the current day and hour bit in the user's
+// ActivityBitmap for that metric. Bit 0 is always the most recent active unit, so
+// marking shifts the words only when the day/hour rolls over. Streak, "N of the last
+// M" and longest-run queries are popcount/ctz over at most six words, independent
+// of how many events were recorded. Days and hours are UTC.
+
+// Shift the bitmap so bit 0 represents `unit` and set it; late events set older bits
+static void activity_mark_words(uint64_t* words, int nwords, int32_t* last, int32_t unit) {
+    if (unit == *last) {
+        words[0] |= 1;
+        return;
+    }
+    if (unit < *last) {
+        int32_t age = *last - unit;
+        if (age < nwords * 64) words[age / 64] |= (uint64_t)1 << (age % 64);
+        return;
+    }
+
+    int32_t shift = *last ? unit - *last : nwords * 64;
+    if (shift >= nwords * 64) {
+        memset(words, 0, (size_t)nwords * sizeof(uint64_t));
+    } else {
+        int word_shift = shift / 64, bit_shift = shift % 64;
+        for (int i = nwords - 1; i >= 0; i--) {
+            uint64_t hi = i - word_shift >= 0 ? words[i - word_shift] : 0;
+            uint64_t lo = i - word_shift - 1 >= 0 ? words[i - word_shift - 1] : 0;
+            words[i] = bit_shift ? (hi << bit_shift) | (lo >> (64 - bit_shift)) : hi;
+        }
+    }
+    words[0] |= 1;
+    *last = unit;
+}
+
+static inline void activity_mark(ActivityBitmap* a, int64_t unix_sec) {
+    int32_t day = (int32_t)(unix_sec / 86400), hour = (int32_t)(unix_sec / 3600);
+    if (day == a->last_day && hour == a->last_hour) return;  // Both bits already set
+    activity_mark_words(a->days, ACTIVITY_DAY_WORDS, &a->last_day, day);
+    activity_mark_words(a->hours, ACTIVITY_HOUR_WORDS, &a->last_hour, hour);
+}
+
+// Consecutive active units ending at `now` (a run ending one unit earlier still counts)
+static int activity_streak(const uint64_t* words, int nwords, int32_t last, int32_t now) {
+    if (!last || now - last > 1) return 0;
+    int run = 0;
+    for (int i = 0; i < nwords; i++) {
+        if (~words[i] == 0) {
+            run += 64;
+            continue;
+        }
+        return run + __builtin_ctzll(~words[i]);
+    }
+    return run;
+}
+
+// Active units among the `window` units ending at `now`
+static int activity_count_recent(const uint64_t* words, int nwords, int32_t last, int32_t now, int window) {
+    int64_t bits = (int64_t)window - (now - last);
+    if (!last || bits <= 0) return 0;
+    if (bits > nwords * 64) bits = nwords * 64;
+    int count = 0;
+    for (int i = 0; bits > 0; i++, bits -= 64) {
+        uint64_t mask = bits >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << bits) - 1;
+        count += __builtin_popcountll(words[i] & mask);
+    }
+    return count;
+}
+
+// Longest run of active units anywhere in the bitmap; one ctz per run boundary
+static int activity_longest_run(const uint64_t* words, int nwords) {
+    int best = 0, run = 0;
+    for (int i = 0; i < nwords; i++) {
+        uint64_t w = words[i];
+        int pos = 0;
+        while (pos < 64) {
+            uint64_t rest = w >> pos;
+            if (rest & 1) {
+                int ones = ~rest ? __builtin_ctzll(~rest) : 64 - pos;
+                if (pos + ones > 64) ones = 64 - pos;
+                run += ones;
+                pos += ones;
+            } else {
+                if (run > best) best = run;
+                run = 0;
+                if (!rest) break;
+                pos += __builtin_ctzll(rest);
+            }
+        }
+    }
+    return run > best ? run : best;
+}
+
+// Value an achievement's target is compared against
+static int64_t achievement_value_locked(const UserAchievementState* user, const Achievement* ach, time_t* now) {
+    const ActivityBitmap* a = &user->activity[ach->metric];
+    switch (ach->kind) {
+        case ACHIEVEMENT_DAILY_STREAK:
+            if (!*now) *now = time(NULL);
+            return activity_streak(a->days, ACTIVITY_DAY_WORDS, a->last_day, (int32_t)(*now / 86400));
+        case ACHIEVEMENT_HOURLY_STREAK:
+            if (!*now) *now = time(NULL);
+            return activity_streak(a->hours, ACTIVITY_HOUR_WORDS, a->last_hour, (int32_t)(*now / 3600));
+        case ACHIEVEMENT_BEST_DAILY_STREAK:
+            return activity_longest_run(a->days, ACTIVITY_DAY_WORDS);
+        case ACHIEVEMENT_ACTIVE_DAYS_30:
+            if (!*now) *now = time(NULL);
+            return activity_count_recent(a->days, ACTIVITY_DAY_WORDS, a->last_day, (int32_t)(*now / 86400), 30);
+        default:
+            return user->metrics[ach->metric];
+    }
+}
+
+// ==================== PER-USER ACHIEVEMENT SHARDS ====================
+// Achievement progress is kept per user_id (one row per user_achievements entry)
+// and partitioned across ACHIEVEMENT_SHARDS, each with its own lock and dirty
+// tracking. An event only locks the shard owning its user, so one busy user never
+// contends with the others. Definitions in engine.achievements are read-only after load.
+
+static inline uint32_t user_hash(int user_id) {
+    return (uint32_t)user_id * 2654435761u;
+}
+
+static inline int user_shard_index(int user_id) {
+    return (int)((user_hash(user_id) >> 16) & (ACHIEVEMENT_SHARDS - 1));
+}
+
+// Find (optionally create) a user's state inside a locked shard
+static UserAchievementState* shard_find_user_locked(AchievementShard* shard, int user_id, int create) {
+    uint32_t h = user_hash(user_id);
+    for (int probe = 0; probe < MAX_USERS_PER_SHARD; probe++) {
+        int slot = (int)((h + probe) & (MAX_USERS_PER_SHARD - 1));
+        UserAchievementState* user = shard->users[slot];
+        if (!user) {
+            if (!create || shard->user_count >= MAX_USERS_PER_SHARD * 3 / 4) return NULL;
+            user = calloc(1, sizeof(*user));
+            if (!user) return NULL;
+            user->user_id = user_id;
+            shard->users[slot] = user;
+            shard->user_count++;
+            return user;
+        }
+        if (user->user_id == user_id) return user;
+    }
+    return NULL;
+}
+
+static inline void shard_touch_locked(UserAchievementState* user) {
+    __atomic_store_n(&user->version, user->version + 1, __ATOMIC_RELEASE);
+}
+
+static inline void shard_mark_dirty_locked(AchievementShard* shard, UserAchievementState* user) {
+    shard_touch_locked(user);
+    if (!user->dirty) {
+        user->dirty = 1;
+        shard->dirty_users++;
+    }
+}
+
+// Index of a loaded achievement definition by id, -1 if unknown
+static int find_achievement_index(const char* id) {
+    int idx = builtin_achievement_index(id);
+    if (idx >= 0) return idx;
+    for (int i = BUILTIN_ACHIEVEMENT_COUNT; i < engine.achievement_count; i++) {
+        if (strcmp(engine.achievements[i].id, id) == 0) return i;
+    }
+    return -1;
+}
+
+void init_achievement_shards(void) {
+    for (int i = 0; i < ACHIEVEMENT_SHARDS; i++) {
+        pthread_mutex_init(&engine.shards[i].lock, NULL);
+    }
+}
+
+// Number of users with unsaved changes across all shards
+static int achievement_shards_dirty(void) {
+    int dirty = 0;
+    for (int i = 0; i < ACHIEVEMENT_SHARDS; i++) {
+        pthread_mutex_lock(&engine.shards[i].lock);
+        dirty += engine.shards[i].dirty_users;
+        pthread_mutex_unlock(&engine.shards[i].lock);
+    }
+    return dirty;
+}
+
+static void journal_define_metric(int metric_id, const char* name);
+
+// Register a metric by name; returns its id (existing id if already registered)
+int register_metric(const char* name) {
+    pthread_mutex_lock(&metric_lock);
+    for (int i = 0; i < metric_count; i++) {
+        if (strcmp(metric_names[i], name) == 0) {
+            pthread_mutex_unlock(&metric_lock);
+            return i;
+        }
+    }
+    int id = -1;
+    if (metric_count < MAX_METRICS) {
+        char* copy = strdup(name);
+        if (copy) {
+            id = metric_count;
+            metric_names[metric_count++] = copy;
+            journal_define_metric(id, copy);
+        }
+    }
+    pthread_mutex_unlock(&metric_lock);
+    return id;
+}
+
+// Register a gauge: its events carry the current value, which replaces the
+// metric instead of adding to it
+int register_gauge_metric(const char* name) {
+    int id = register_metric(name);
+    if (id >= 0) __atomic_fetch_or(&metric_gauges, 1u << id, __ATOMIC_RELAXED);
+    return id;
+}
+
+int lookup_metric(const char* name) {
+    pthread_mutex_lock(&metric_lock);
+    for (int i = 0; i < metric_count; i++) {
+        if (strcmp(metric_names[i], name) == 0) {
+            pthread_mutex_unlock(&metric_lock);
+            return i;
+        }
+    }
+    pthread_mutex_unlock(&metric_lock);
+    return -1;
+}
+
+// Rebuild the metric -> achievements routing table after definitions change
+void rebuild_metric_index(void) {
+    memset(engine.metric_achievement_count, 0, sizeof(engine.metric_achievement_count));
     for (int i = 0; i < engine.achievement_count; i++) {
-        if (strcmp(engine.achievements[i].id, id) == 0 && 
-            !engine.achievements[i].unlocked) {
-            
-            engine.achievements[i].unlocked = 1;
-            engine.achievements[i].unlock_time = time(NULL);
-            
-            char msg[256];
-            snprintf(msg, sizeof(msg), 
-                    "🏆 Achievement Unlocked: %s!
-%s", 
-                    engine.achievements[i].name,
-                    engine.achievements[i].description);
-            
-            send_notification(msg, "achievement", 5);
-            log_engine_event("Achievement unlocked");
-            save_engine_data();
-            break;
+        int m = engine.achievements[i].metric;
+        engine.achievement_targets[i] = m >= 0 ? engine.achievements[i].target : INT64_MAX;  // Manual: never by value
+        if (m < 0 || m >= MAX_METRICS) continue;
+        engine.metric_achievements[m][engine.metric_achievement_count[m]++] = i;
+    }
+}
+
+static int load_achievement_definition(const char* id, const char* name, const char* description,
+                                       int target, int metric, int kind);
+static void journal_record_define(const Achievement* ach);
+
+// Add or change a custom achievement definition (shard locks held)
+static int apply_achievement_definition(const char* id, const char* name, const char* description,
+                                        int target, int metric_id, int kind) {
+    int idx = find_achievement_index(id);
+    if (idx < 0) return load_achievement_definition(id, name, description, target, metric_id, kind);
+    // Old strings are not freed: announcers read definitions without locks
+    Achievement* ach = &engine.achievements[idx];
+    if (strcmp(ach->name, name) != 0) ach->name = strdup(name);
+    if (strcmp(ach->description, description) != 0) ach->description = strdup(description);
+    ach->target = target;
+    ach->metric = metric_id;
+    ach->kind = metric_id >= 0 ? kind : ACHIEVEMENT_TOTAL;
+    return idx;
+}
+
+// Define (or redefine) a custom achievement at runtime; built-ins cannot change.
+// Returns its index, -1 on error. Call reevaluate_all_achievements() to apply it.
+int define_achievement(const char* id, const char* name, const char* description, int target, int metric_id, int kind) {
+    if (builtin_achievement_index(id) >= 0 || metric_id >= MAX_METRICS || strlen(id) >= 32) return -1;
+    for (int s = 0; s < ACHIEVEMENT_SHARDS; s++) pthread_mutex_lock(&engine.shards[s].lock);
+    int idx = apply_achievement_definition(id, name, description, target, metric_id, kind);
+    if (idx >= 0) rebuild_metric_index();
+    for (int s = ACHIEVEMENT_SHARDS - 1; s >= 0; s--) pthread_mutex_unlock(&engine.shards[s].lock);
+    if (idx < 0) return -1;
+    journal_record_define(&engine.achievements[idx]);
+    journal_sync();
+    return idx;
+}
+
+// Re-evaluate the achievements bound to one metric for a user (shard lock held).
+// Newly unlocked achievements are appended to `unlocks`; returns the new count.
+static int evaluate_metric_locked(UserAchievementState* user, int metric_id, PendingUnlock* unlocks, int unlock_count) {
+    time_t now = 0;
+
+    for (int k = 0; k < engine.metric_achievement_count[metric_id]; k++) {
+        int i = engine.metric_achievements[metric_id][k];
+        AchievementProgress* p = &user->progress[i];
+        if (p->unlocked) continue;
+        int64_t value = achievement_value_locked(user, &engine.achievements[i], &now);
+        int target = engine.achievements[i].target;
+        int progress = value >= target ? target : (value < 0 ? 0 : (int)value);
+        if (progress == p->progress && value < target) continue;
+        p->progress = progress;
+        if (value >= target) {
+            if (!now) now = time(NULL);
+            p->unlocked = 1;
+            p->unlock_time = now;
+            unlocks[unlock_count].user_id = user->user_id;
+            unlocks[unlock_count].achievement = i;
+            unlocks[unlock_count].unlock_time = now;
+            unlock_count++;
+        }
+        publish_progress_locked(user, p, i);
+    }
+    return unlock_count;
+}
+
+static int persist_queue_unlocks(const PendingUnlock* unlocks, int count);
+static void request_persist(int what);
+
+// Journal a batch of unlocks and hand them to the persistence writer, which
+// announces them once its sync made them durable. Without a writer (or with its
+// queue full) sync here and announce at once.
+static void announce_pending_unlocks(const PendingUnlock* unlocks, int count) {
+    if (count == 0) return;
+    for (int k = 0; k < count; k++) {
+        journal_record_unlock(unlocks[k].user_id, engine.achievements[unlocks[k].achievement].id, unlocks[k].unlock_time);
+    }
+    if (persist_queue_unlocks(unlocks, count)) return;
+    journal_sync();
+    for (int k = 0; k < count; k++) {
+        announce_unlock(unlocks[k].user_id, &engine.achievements[unlocks[k].achievement]);
+    }
+}
+
+static void leaderboard_update_locked(UserAchievementState* user, int metric_id);
+
+// Evaluate every (user, metric) pair touched in the current shard pass
+static int evaluate_touched_locked(AchievementShard* shard, BatchTouched* touched, int touched_count,
+                                   PendingUnlock* unlocks, int* unlock_count) {
+    int total = 0;
+    for (int t = 0; t < touched_count; t++) {
+        uint32_t metrics = touched[t].metrics;
+        while (metrics) {
+            int m = __builtin_ctz(metrics);
+            metrics &= metrics - 1;
+            leaderboard_update_locked(touched[t].user, m);
+            const ActivityBitmap* a = &touched[t].user->activity[m];
+            journal_record_metric(touched[t].user->user_id, m, touched[t].user->metrics[m],
+                                  a->last_hour ? (int64_t)a->last_hour * 3600 : 0);
+            if (*unlock_count + engine.metric_achievement_count[m] > BATCH_UNLOCK_CAPACITY) {
+                // Announcing does I/O and may save; never do that under the shard lock
+                pthread_mutex_unlock(&shard->lock);
+                announce_pending_unlocks(unlocks, *unlock_count);
+                total += *unlock_count;
+                *unlock_count = 0;
+                pthread_mutex_lock(&shard->lock);
+            }
+            *unlock_count = evaluate_metric_locked(touched[t].user, m, unlocks, *unlock_count);
+        }
+        shard_mark_dirty_locked(shard, touched[t].user);
+    }
+    return total;
+}
+
+// Apply a batch of events. Each shard lock is taken once per batch and each touched
+// (user, metric) pair is evaluated once, so per-event cost is a hash probe and an add.
+// Returns the number of achievements unlocked.
+int submit_metric_batch(const sweetexp_event* events, uint32_t count) {
+    uint32_t shard_mask = 0;
+    int total = 0;
+    int64_t now_sec = (int64_t)time(NULL);
+    uint32_t gauges = __atomic_load_n(&metric_gauges, __ATOMIC_RELAXED);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (events[i].metric_id < MAX_METRICS) shard_mask |= 1u << user_shard_index(events[i].user_id);
+    }
+
+    for (int s = 0; s < ACHIEVEMENT_SHARDS; s++) {
+        if (!(shard_mask & (1u << s))) continue;
+
+        AchievementShard* shard = &engine.shards[s];
+        BatchTouched touched[BATCH_TOUCHED_USERS];
+        PendingUnlock unlocks[BATCH_UNLOCK_CAPACITY];
+        int touched_count = 0;
+        int unlock_count = 0;
+        UserAchievementState* user = NULL;
+
+        pthread_mutex_lock(&shard->lock);
+        for (uint32_t i = 0; i < count; i++) {
+            const sweetexp_event* ev = &events[i];
+            if (ev->metric_id >= MAX_METRICS || user_shard_index(ev->user_id) != s) continue;
+            if (!user || user->user_id != ev->user_id) {
+                user = shard_find_user_locked(shard, ev->user_id, 1);
+                if (!user) continue;
+            }
+            rollup_cell_add(&shard->rollup_pending[ev->metric_id], ev->delta);
+            if (gauges & (1u << ev->metric_id)) {
+                user->metrics[ev->metric_id] = ev->delta;  // A gauge event carries the sample
+            } else {
+                user->metrics[ev->metric_id] += ev->delta;
+                if (ev->delta > 0) {
+                    activity_mark(&user->activity[ev->metric_id], ev->timestamp_ms ? ev->timestamp_ms / 1000 : now_sec);
+                }
+            }
+
+            int t = 0;
+            while (t < touched_count && touched[t].user != user) t++;
+            if (t == BATCH_TOUCHED_USERS) {
+                total += evaluate_touched_locked(shard, touched, touched_count, unlocks, &unlock_count);
+                touched_count = t = 0;
+            }
+            if (t == touched_count) {
+                touched[t].user = user;
+                touched[t].metrics = 0;
+                touched_count++;
+            }
+            touched[t].metrics |= 1u << ev->metric_id;
         }
+        total += evaluate_touched_locked(shard, touched, touched_count, unlocks, &unlock_count);
+        pthread_mutex_unlock(&shard->lock);
+
+        announce_pending_unlocks(unlocks, unlock_count);
+        total += unlock_count;
+    }
+    return total;
+}
+
+// Apply a metric delta for one user and evaluate the achievements bound to it.
+// Returns the number of achievements unlocked, -1 on error.
+int submit_metric_event(int user_id, int metric_id, int64_t delta) {
+    if (metric_id < 0 || metric_id >= MAX_METRICS) return -1;
+
+    sweetexp_event ev = {(uint32_t)metric_id, user_id, delta, 0};
+    return submit_metric_batch(&ev, 1);
+}
+
+// Unlock an achievement for a user directly; returns 0 if newly unlocked
+int unlock_user_achievement(int user_id, const char* id) {
+    int idx = find_achievement_index(id);
+    if (idx < 0) return -1;
+
+    AchievementShard* shard = &engine.shards[user_shard_index(user_id)];
+    pthread_mutex_lock(&shard->lock);
+    UserAchievementState* user = shard_find_user_locked(shard, user_id, 1);
+    if (!user || user->progress[idx].unlocked) {
+        pthread_mutex_unlock(&shard->lock);
+        return -1;
     }
+    user->progress[idx].unlocked = 1;
+    user->progress[idx].progress = engine.achievements[idx].target;
+    user->progress[idx].unlock_time = time(NULL);
+    publish_progress_locked(user, &user->progress[idx], idx);
+    shard_mark_dirty_locked(shard, user);
+    time_t unlock_time = user->progress[idx].unlock_time;
+    pthread_mutex_unlock(&shard->lock);
+
+    journal_record_unlock(user_id, engine.achievements[idx].id, unlock_time);
+    PendingUnlock unlock = {user_id, idx, unlock_time};
+    if (persist_queue_unlocks(&unlock, 1)) return 0;
+    journal_sync();
+    announce_unlock(user_id, &engine.achievements[idx]);
+    return 0;
 }
 
 // Achievement monitoring thread
 void* achievement_monitor_thread(void* arg) {
-    struct timespec ts = {0, CHECK_INTERVAL_MS * 1000000L};
+    struct timespec ts = {CHECK_INTERVAL_MS / 1000, (CHECK_INTERVAL_MS % 1000) * 1000000L};
+    int checks = 0;
     
     while (engine.enabled) {
-        pthread_mutex_lock(&engine.data_mutex);
-        check_achievement_progress();
-        pthread_mutex_unlock(&engine.data_mutex);
+        check_achievement_progress();  // Shard locks are taken per event
+        int persist_what = PERSIST_SYNC;
+        if (journal_size() >= JOURNAL_CHECKPOINT_BYTES ||
+            (++checks % JOURNAL_CHECKPOINT_CHECKS == 0 && achievement_shards_dirty())) {
+            persist_what |= PERSIST_CHECKPOINT;  // Snapshot and retire the journal
+        }
+        request_persist(persist_what);
+        flush_metric_rollups();
+        refresh_notification_filters();  // Recompiles only when the prefs file changed
         nanosleep(&ts, NULL);
     }
     return NULL;
@@ -252,7 +1361,7 @@ void* achievement_monitor_thread(void* arg) {
 
 // Notification dispatcher thread
 void* notification_dispatcher_thread(void* arg) {
-    struct timespec ts = {0, 2000000000L};  // 2 seconds
+    struct timespec ts = {2, 0};  // tv_nsec must stay below 1e9 or nanosleep() fails at once
     
     while (engine.enabled) {
         // Dispatch queued notifications
@@ -264,6 +1373,7 @@ void* notification_dispatcher_thread(void* arg) {
             engine.notification_count--;
         }
         pthread_mutex_unlock(&engine.data_mutex);
+        flush_notification_digests(0);
         
         // Random notification chance
         if (rand() % 100 < 5) {  // 5% chance every 2s
@@ -275,164 +1385,3478 @@ void* notification_dispatcher_thread(void* arg) {
     return NULL;
 }
 
-// Wayland event listener (placeholder for compositor integration)
-void* wayland_event_listener(void* arg) {
-    static int event_count = 0;
-    while (engine.enabled) {
-        // Monitor Wayland events at /lumen-motonexus6/system/graph/mod/system2Dengine.LUMENGUI/core/wayland
-        // Placeholder: increment counter based on Wayland socket activity
-        event_count += rand() % 10;
-        
-        // Queue achievement progress notification
-        pthread_mutex_lock(&engine.data_mutex);
-        if (event_count % 50 == 0 && engine.notification_count < MAX_NOTIFICATIONS - 1) {
-            Notification* notif = &engine.notification_queue[engine.notification_tail];
-            snprintf(notif->message, sizeof(notif->message), 
-                    "Wayland events: %d processed", event_count);
-            strcpy(notif->type, "system");
-            notif->priority = 1;
-            notif->timestamp = time(NULL);
-            engine.notification_tail = (engine.notification_tail + 1) % MAX_NOTIFICATIONS;
-            engine.notification_count++;
+// ==================== BATCH RE-EVALUATION ====================
+// After a restore or a replay nearly every achievement may have moved, so instead of
+// per-event evaluation each user's values are gathered into one contiguous array and
+// compared against engine.achievement_targets by a vector kernel (sweetexp_eval.h:
+// AVX2/SSE4.2 on x86, NEON on ARM, scalar elsewhere). The kernel yields a bitmask of
+// newly unlocked achievements and unlocks are dispatched from its set bits.
+// SweetExpEvalBench.c measures the kernels on a 100k-entry workload.
+
+// Re-evaluate every achievement of every known user; returns the number unlocked
+int reevaluate_all_achievements(void) {
+    sweetexp_unlock_mask_fn unlock_mask = sweetexp_eval_select(NULL);
+    int n = engine.achievement_count;
+    int64_t values[MAX_ACHIEVEMENTS] __attribute__((aligned(32)));
+    PendingUnlock unlocks[BATCH_UNLOCK_CAPACITY];
+    int total = 0;
+
+    _Static_assert(MAX_ACHIEVEMENTS <= 64, "one mask word per user");
+
+    for (int s = 0; s < ACHIEVEMENT_SHARDS; s++) {
+        AchievementShard* shard = &engine.shards[s];
+        int unlock_count = 0;
+
+        pthread_mutex_lock(&shard->lock);
+        for (int slot = 0; slot < MAX_USERS_PER_SHARD; slot++) {
+            UserAchievementState* user = shard->users[slot];
+            if (!user) continue;
+
+            time_t now = 0;
+            uint64_t unlocked = 0, newly;
+            for (int i = 0; i < n; i++) {
+                const Achievement* ach = &engine.achievements[i];
+                values[i] = ach->metric >= 0 ? achievement_value_locked(user, ach, &now) : 0;
+                unlocked |= (uint64_t)(user->progress[i].unlocked != 0) << i;
+            }
+            unlock_mask(values, engine.achievement_targets, &unlocked, &newly, (size_t)n);
+
+            if (newly && unlock_count + MAX_ACHIEVEMENTS > BATCH_UNLOCK_CAPACITY) {
+                pthread_mutex_unlock(&shard->lock);
+                announce_pending_unlocks(unlocks, unlock_count);
+                total += unlock_count;
+                unlock_count = 0;
+                pthread_mutex_lock(&shard->lock);
+            }
+
+            int changed = newly != 0;
+            if (newly && !now) now = time(NULL);
+            for (uint64_t bits = newly; bits; bits &= bits - 1) {
+                int i = __builtin_ctzll(bits);
+                AchievementProgress* p = &user->progress[i];
+                p->unlocked = 1;
+                p->unlock_time = now;
+                p->progress = engine.achievements[i].target;
+                publish_progress_locked(user, p, i);
+                unlocks[unlock_count].user_id = user->user_id;
+                unlocks[unlock_count].achievement = i;
+                unlocks[unlock_count].unlock_time = now;
+                unlock_count++;
+            }
+
+            // Progress of still-locked achievements follows the value
+            for (int i = 0; i < n; i++) {
+                AchievementProgress* p = &user->progress[i];
+                if (p->unlocked || engine.achievements[i].metric < 0) continue;
+                int progress = values[i] < 0 ? 0 : (int)values[i];
+                if (progress == p->progress) continue;
+                p->progress = progress;
+                publish_progress_locked(user, p, i);
+                changed = 1;
+            }
+            if (changed) shard_mark_dirty_locked(shard, user);
+        }
+        pthread_mutex_unlock(&shard->lock);
+
+        announce_pending_unlocks(unlocks, unlock_count);
+        total += unlock_count;
+    }
+    return total;
+}
+
+// ==================== LEADERBOARDS ====================
+// One order-statistic skip list per metric ranks users by value (descending, ties by
+// user id). Every link records the number of ranks it skips, so both "entries from
+// rank R" and "rank of user U" are a single O(log n) descent. A user's node is
+// created on first change and moved (remove + insert, no re-sort) whenever a batch
+// changes the metric; the node's memory is reused. Achievement progress of TOTAL
+// achievements is a clamp of the metric, so the metric board also ranks them.
+// Lock order: shard lock, then leaderboard lock.
+
+typedef struct {
+    pthread_mutex_t lock;
+    int level;
+    uint32_t length;
+    uint32_t seed;
+    RankNode* head;
+} Leaderboard;
+
+static Leaderboard leaderboards[MAX_METRICS];
+
+static RankNode* rank_node_new(int level) {
+    RankNode* node = calloc(1, sizeof(RankNode) + (size_t)level * sizeof(node->links[0]));
+    if (node) node->level = level;
+    return node;
+}
+
+void init_leaderboards(void) {
+    for (int m = 0; m < MAX_METRICS; m++) {
+        pthread_mutex_init(&leaderboards[m].lock, NULL);
+        leaderboards[m].level = 1;
+        leaderboards[m].seed = 0x9E3779B9u ^ (uint32_t)m;
+        leaderboards[m].head = rank_node_new(RANK_MAX_LEVEL);
+    }
+}
+
+// Geometric level with p = 1/4 from a per-board xorshift
+static int rank_random_level(Leaderboard* lb) {
+    uint32_t x = lb->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    lb->seed = x;
+    int level = 1;
+    while ((x & 3) == 0 && level < RANK_MAX_LEVEL) {
+        level++;
+        x >>= 2;
+    }
+    return level;
+}
+
+// Higher score first, then lower user id
+static inline int rank_before(const RankNode* a, const RankNode* b) {
+    return a->score > b->score || (a->score == b->score && a->user_id < b->user_id);
+}
+
+static void rank_insert_locked(Leaderboard* lb, RankNode* node) {
+    RankNode* update[RANK_MAX_LEVEL];
+    uint32_t rank[RANK_MAX_LEVEL];
+    RankNode* x = lb->head;
+
+    for (int i = lb->level - 1; i >= 0; i--) {
+        rank[i] = i == lb->level - 1 ? 0 : rank[i + 1];
+        while (x->links[i].next && rank_before(x->links[i].next, node)) {
+            rank[i] += x->links[i].span;
+            x = x->links[i].next;
+        }
+        update[i] = x;
+    }
+    if (node->level > lb->level) {
+        for (int i = lb->level; i < node->level; i++) {
+            rank[i] = 0;
+            update[i] = lb->head;
+            update[i]->links[i].span = lb->length;
+        }
+        lb->level = node->level;
+    }
+    for (int i = 0; i < node->level; i++) {
+        node->links[i].next = update[i]->links[i].next;
+        update[i]->links[i].next = node;
+        node->links[i].span = update[i]->links[i].span - (rank[0] - rank[i]);
+        update[i]->links[i].span = (rank[0] - rank[i]) + 1;
+    }
+    for (int i = node->level; i < lb->level; i++) update[i]->links[i].span++;
+    lb->length++;
+}
+
+static void rank_remove_locked(Leaderboard* lb, RankNode* node) {
+    RankNode* update[RANK_MAX_LEVEL];
+    RankNode* x = lb->head;
+
+    for (int i = lb->level - 1; i >= 0; i--) {
+        while (x->links[i].next && rank_before(x->links[i].next, node)) x = x->links[i].next;
+        update[i] = x;
+    }
+    for (int i = 0; i < lb->level; i++) {
+        if (update[i]->links[i].next == node) {
+            update[i]->links[i].span += node->links[i].span - 1;
+            update[i]->links[i].next = node->links[i].next;
+        } else {
+            update[i]->links[i].span--;
+        }
+    }
+    while (lb->level > 1 && !lb->head->links[lb->level - 1].next) lb->level--;
+    lb->length--;
+}
+
+// 1-based rank of a node on its board
+static uint32_t rank_of_locked(const Leaderboard* lb, const RankNode* node) {
+    const RankNode* x = lb->head;
+    uint32_t rank = 0;
+    for (int i = lb->level - 1; i >= 0; i--) {
+        while (x->links[i].next && !rank_before(node, x->links[i].next)) {
+            rank += x->links[i].span;
+            x = x->links[i].next;
+        }
+        if (x == node) return rank;
+    }
+    return 0;
+}
+
+// Re-rank a user after its metric changed (shard lock held)
+static void leaderboard_update_locked(UserAchievementState* user, int metric_id) {
+    Leaderboard* lb = &leaderboards[metric_id];
+    RankNode* node = user->rank_nodes[metric_id];
+    int64_t score = user->metrics[metric_id];
+    if (!lb->head || (node && node->score == score)) return;
+
+    pthread_mutex_lock(&lb->lock);
+    if (node) {
+        rank_remove_locked(lb, node);
+    } else if ((node = rank_node_new(rank_random_level(lb))) != NULL) {
+        node->user_id = user->user_id;
+        user->rank_nodes[metric_id] = node;
+    }
+    if (node) {
+        node->score = score;
+        rank_insert_locked(lb, node);
+    }
+    pthread_mutex_unlock(&lb->lock);
+}
+
+// Up to `max` entries starting at 0-based rank `offset`; returns the count
+int leaderboard_top(int metric_id, uint32_t offset, sweetexp_rank_entry* out, int max, uint32_t* total) {
+    if (metric_id < 0 || metric_id >= MAX_METRICS || !leaderboards[metric_id].head) return 0;
+    Leaderboard* lb = &leaderboards[metric_id];
+
+    pthread_mutex_lock(&lb->lock);
+    *total = lb->length;
+
+    // Descend to the node just before `offset`, then walk level 0
+    const RankNode* x = lb->head;
+    uint32_t traversed = 0;
+    for (int i = lb->level - 1; i >= 0; i--) {
+        while (x->links[i].next && traversed + x->links[i].span <= offset) {
+            traversed += x->links[i].span;
+            x = x->links[i].next;
+        }
+    }
+    int count = 0;
+    for (x = x->links[0].next; x && count < max; x = x->links[0].next) {
+        out[count].rank = offset + (uint32_t)count + 1;
+        out[count].user_id = x->user_id;
+        out[count].value = x->score;
+        count++;
+    }
+    pthread_mutex_unlock(&lb->lock);
+    return count;
+}
+
+// Rank and value of one user; returns 0, or -1 if the user is not ranked
+int leaderboard_rank(int metric_id, int user_id, sweetexp_rank_entry* out, uint32_t* total) {
+    if (metric_id < 0 || metric_id >= MAX_METRICS || !leaderboards[metric_id].head) return -1;
+    Leaderboard* lb = &leaderboards[metric_id];
+    AchievementShard* shard = &engine.shards[user_shard_index(user_id)];
+    int result = -1;
+
+    pthread_mutex_lock(&shard->lock);
+    UserAchievementState* user = shard_find_user_locked(shard, user_id, 0);
+    RankNode* node = user ? user->rank_nodes[metric_id] : NULL;
+    pthread_mutex_lock(&lb->lock);
+    *total = lb->length;
+    if (node) {
+        out->rank = rank_of_locked(lb, node);
+        out->user_id = user_id;
+        out->value = node->score;
+        result = 0;
+    }
+    pthread_mutex_unlock(&lb->lock);
+    pthread_mutex_unlock(&shard->lock);
+    return result;
+}
+
+// ==================== HISTORY BACKFILL ====================
+// Gives existing users credit for past activity after a rule is added or fixed.
+// Two kinds of recorded history are replayed. The metric rollup rings hold
+// engine-wide totals, so they only mark the system user's activity bitmaps and
+// never set a counter; the finest ring covering each period is used. NotifEngine's
+// notification history has one JSON line per delivered notification, counted as
+// notifications_sent for its "user_id" (default the system user). It is read from
+// SweetExpHistCompact's segment, starting at the index entry before the window,
+// plus whatever notif_data.dat and an interrupted compaction's .compacting hold.
+// Map: the window is cut into time chunks (rollup buckets, and byte ranges of the
+// history files) that a worker pool turns into private (user, metric) tables of
+// sums and day/hour activity bits. Reduce: tables are folded per user shard in
+// work-item order (sums and ORs, so the result does not depend on scheduling),
+// then merged into live state. A counter only ever rises to its user's replayed
+// history count, a lower bound on the lifetime total; activity bits are added, and
+// reevaluate_all_achievements() unlocks whatever is now earned.
+// Run as `SweetExperiencesEngine --backfill [days] [workers]` before the daemon starts.
+
+typedef struct {
+    int used;
+    int user_id;
+    int metric;
+    int counted;                            // sum is this user's own count
+    int64_t sum;
+    uint64_t days[ACTIVITY_DAY_WORDS];      // Bit k = k days before the backfill's today
+    uint64_t hours[ACTIVITY_HOUR_WORDS];    // Bit k = k hours before its current hour
+} BackfillEntry;
+
+typedef struct {
+    BackfillEntry* entries;
+    uint32_t capacity;                      // Power of two
+    uint32_t count;
+} BackfillTable;
+
+typedef struct {
+    int64_t from;                           // Rollups: [from, to) in unix seconds
+    int64_t to;
+    const char* begin;                      // History: whole lines in [begin, end)
+    const char* end;
+    BackfillTable table;
+} BackfillWork;
+
+typedef struct {
+    int64_t now;
+    int64_t from;
+    int64_t hour_cut;                       // 1h ring from here, 1d ring before
+    int64_t minute_cut;                     // 1m ring from here
+    BackfillWork* work;
+    int work_count;
+    int next;                               // Next work item (atomic)
+    uint8_t additive[MAX_METRICS];          // Rollup sums are deltas, not gauge samples
+} BackfillJob;
+
+static BackfillEntry* backfill_entry(BackfillTable* t, int user_id, int metric) {
+    if ((t->count + 1) * 10 > t->capacity * 7) {
+        uint32_t capacity = t->capacity ? t->capacity * 2 : 256;
+        BackfillEntry* grown = calloc(capacity, sizeof(BackfillEntry));
+        if (!grown) return NULL;
+        for (uint32_t i = 0; i < t->capacity; i++) {
+            if (!t->entries[i].used) continue;
+            uint32_t h = ((uint32_t)t->entries[i].user_id * 0x9E3779B1u ^ (uint32_t)t->entries[i].metric) & (capacity - 1);
+            while (grown[h].used) h = (h + 1) & (capacity - 1);
+            grown[h] = t->entries[i];
+        }
+        free(t->entries);
+        t->entries = grown;
+        t->capacity = capacity;
+    }
+    uint32_t h = ((uint32_t)user_id * 0x9E3779B1u ^ (uint32_t)metric) & (t->capacity - 1);
+    while (t->entries[h].used) {
+        if (t->entries[h].user_id == user_id && t->entries[h].metric == metric) return &t->entries[h];
+        h = (h + 1) & (t->capacity - 1);
+    }
+    BackfillEntry* e = &t->entries[h];
+    e->used = 1;
+    e->user_id = user_id;
+    e->metric = metric;
+    t->count++;
+    return e;
+}
+
+// Record activity at `when`; `counted` adds one to the user's replayed count
+static void backfill_note(BackfillTable* t, const BackfillJob* job, int user_id, int metric,
+                          int64_t when, int counted) {
+    BackfillEntry* e = backfill_entry(t, user_id, metric);
+    if (!e) return;
+    if (counted) {
+        e->counted = 1;
+        e->sum++;
+    }
+    int64_t day_age = job->now / 86400 - when / 86400;
+    int64_t hour_age = job->now / 3600 - when / 3600;
+    if (day_age >= 0 && day_age < ACTIVITY_DAY_WORDS * 64) e->days[day_age / 64] |= (uint64_t)1 << (day_age % 64);
+    if (hour_age >= 0 && hour_age < ACTIVITY_HOUR_WORDS * 64) e->hours[hour_age / 64] |= (uint64_t)1 << (hour_age % 64);
+}
+
+// Replay rollup buckets of one ring that fall in [from, to) as system-user activity
+static void backfill_ring(BackfillWork* w, const BackfillJob* job, const RollupRing* ring, int64_t from, int64_t to) {
+    if (!ring->header || from >= to) return;
+    int64_t res = ring->resolution_sec;
+    for (int64_t bucket = from - from % res; bucket < to; bucket += res) {
+        if (bucket < from) continue;
+        const sweetexp_rollup_slot* slot = &ring->slots[(bucket / res) % ring->slot_count];
+        if (slot->bucket_start != bucket) continue;
+        for (int m = 0; m < metric_count; m++) {
+            const sweetexp_rollup_cell* c = &slot->cells[m];
+            if (c->count && c->sum > 0 && job->additive[m]) {
+                backfill_note(&w->table, job, SWEET_DEFAULT_USER_ID, m, bucket, 0);
+            }
+        }
+    }
+}
+
+static int64_t json_int_field(const char* line, const char* end, const char* key, size_t key_len, int64_t fallback) {
+    const char* p = memmem(line, end - line, key, key_len);
+    if (!p) return fallback;
+    p += key_len;
+    while (p < end && (*p == ' ' || *p == ':')) p++;
+    return p < end ? strtoll(p, NULL, 10) : fallback;
+}
+
+// Replay notification history lines in [begin, end)
+static void backfill_history_lines(BackfillWork* w, const BackfillJob* job) {
+    const char* p = w->begin;
+    while (p < w->end) {
+        const char* nl = memchr(p, '\n', w->end - p);
+        const char* line_end = nl ? nl : w->end;
+        int64_t when = json_int_field(p, line_end, "\"timestamp\"", 11, 0);
+        if (when >= job->from && when <= job->now) {
+            int user_id = (int)json_int_field(p, line_end, "\"user_id\"", 9, SWEET_DEFAULT_USER_ID);
+            backfill_note(&w->table, job, user_id, METRIC_NOTIFICATIONS_SENT, when, 1);
+        }
+        p = line_end + 1;
+    }
+}
+
+static void* backfill_worker(void* arg) {
+    BackfillJob* job = arg;
+    int i;
+    while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->work_count) {
+        BackfillWork* w = &job->work[i];
+        if (w->begin) {
+            backfill_history_lines(w, job);
+            continue;
+        }
+        // Finest ring first: 1d before hour_cut, 1h before minute_cut, 1m after
+        backfill_ring(w, job, &rollup_rings[2], w->from, w->to < job->hour_cut ? w->to : job->hour_cut);
+        backfill_ring(w, job, &rollup_rings[1], w->from > job->hour_cut ? w->from : job->hour_cut,
+                      w->to < job->minute_cut ? w->to : job->minute_cut);
+        backfill_ring(w, job, &rollup_rings[0], w->from > job->minute_cut ? w->from : job->minute_cut, w->to);
+    }
+    return NULL;
+}
+
+// Fold one replayed entry into live state (shard lock held)
+static void backfill_apply_locked(AchievementShard* shard, const BackfillEntry* e, int64_t now) {
+    UserAchievementState* user = shard_find_user_locked(shard, e->user_id, 1);
+    if (!user) return;
+    ActivityBitmap* a = &user->activity[e->metric];
+    if (e->counted && e->sum > user->metrics[e->metric]) user->metrics[e->metric] = e->sum;
+    for (int w = ACTIVITY_DAY_WORDS - 1; w >= 0; w--) {
+        for (uint64_t bits = e->days[w]; bits; bits &= bits - 1) {
+            int32_t day = (int32_t)(now / 86400) - (w * 64 + __builtin_ctzll(bits));
+            activity_mark_words(a->days, ACTIVITY_DAY_WORDS, &a->last_day, day);
+        }
+    }
+    for (int w = ACTIVITY_HOUR_WORDS - 1; w >= 0; w--) {
+        for (uint64_t bits = e->hours[w]; bits; bits &= bits - 1) {
+            int32_t hour = (int32_t)(now / 3600) - (w * 64 + __builtin_ctzll(bits));
+            activity_mark_words(a->hours, ACTIVITY_HOUR_WORDS, &a->last_hour, hour);
+        }
+    }
+    leaderboard_update_locked(user, e->metric);
+    journal_record_metric(user->user_id, e->metric, user->metrics[e->metric],
+                          a->last_hour ? (int64_t)a->last_hour * 3600 : 0);
+    shard_mark_dirty_locked(shard, user);
+}
+
+typedef struct {
+    char* base;
+    size_t size;
+    ino_t inode;
+} BackfillMap;
+
+// Map a history file read-only; a missing or empty file leaves `m` empty
+static void backfill_map(BackfillMap* m, const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        m->base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m->base == MAP_FAILED) {
+            m->base = NULL;
+        } else {
+            m->size = (size_t)st.st_size;
+            m->inode = st.st_ino;
+            madvise(m->base, m->size, MADV_SEQUENTIAL);
+        }
+    }
+    if (fd >= 0) close(fd);
+}
+
+static void backfill_unmap(BackfillMap* m) {
+    if (m->base) munmap(m->base, m->size);
+    m->base = NULL;
+}
+
+// Queue [begin, end) as at most `chunks` work items split on line boundaries
+static void backfill_split_lines(BackfillJob* job, const char* begin, const char* end, int chunks) {
+    size_t size = (size_t)(end - begin);
+    const char* cursor = begin;
+    for (int c = 0; c < chunks && cursor < end; c++) {
+        const char* cut = c == chunks - 1 ? end : begin + size * (size_t)(c + 1) / chunks;
+        if (cut < cursor) cut = cursor;
+        const char* nl = cut < end ? memchr(cut, '\n', (size_t)(end - cut)) : NULL;
+        cut = nl ? nl + 1 : end;
+        BackfillWork* w = &job->work[job->work_count++];
+        w->begin = cursor;
+        w->end = cut;
+        cursor = cut;
+    }
+}
+
+// Replay `days` of recorded history on `workers` threads; returns achievements unlocked
+int backfill_history(int days, int workers) {
+    if (days <= 0) days = BACKFILL_DEFAULT_DAYS;
+    if (workers <= 0) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers < 1) workers = 1;
+    if (workers > BACKFILL_MAX_WORKERS) workers = BACKFILL_MAX_WORKERS;
+
+    BackfillJob job;
+    memset(&job, 0, sizeof(job));
+    job.now = (int64_t)time(NULL);
+    job.from = job.now - (int64_t)days * 86400;
+    // Each ring covers res * (slot_count - 1) seconds back; start finer rings on a
+    // boundary of the next coarser one so buckets never overlap
+    job.hour_cut = job.now - 3600LL * (rollup_rings[1].slot_count - 1);
+    job.hour_cut += (86400 - job.hour_cut % 86400) % 86400;
+    job.minute_cut = job.now - 60LL * (rollup_rings[0].slot_count - 1);
+    job.minute_cut += (3600 - job.minute_cut % 3600) % 3600;
+    // Gauge samples (cpu_busy_pct, mem_used_pct) do not add up over time
+    uint32_t gauges = __atomic_load_n(&metric_gauges, __ATOMIC_RELAXED);
+    for (int m = 0; m < MAX_METRICS; m++) job.additive[m] = !(gauges & (1u << m));
+
+    // History files, each cut into chunks on line boundaries: the segment from the
+    // first index entry that can reach the window, then lines not compacted yet
+    char compacting[sizeof(SWEETEXP_HIST_LOG_PATH) + 16];
+    snprintf(compacting, sizeof(compacting), "%s.compacting", SWEETEXP_HIST_LOG_PATH);
+    BackfillMap maps[3];
+    memset(maps, 0, sizeof(maps));
+    backfill_map(&maps[0], SWEETEXP_HIST_SEGMENT_PATH);
+    backfill_map(&maps[1], compacting);
+    backfill_map(&maps[2], SWEETEXP_HIST_LOG_PATH);
+    const char* ranges[3][2] = {{NULL, NULL}, {NULL, NULL}, {NULL, NULL}};
+    const sweetexp_hist_header* seg = maps[0].base ? sweetexp_hist_validate(maps[0].base, maps[0].size) : NULL;
+    if (seg && seg->last_timestamp >= job.from) {
+        const sweetexp_hist_index* entry =
+            sweetexp_hist_seek((const sweetexp_hist_index*)(maps[0].base + seg->index_offset), seg->index_count, job.from);
+        const char* data = maps[0].base + seg->data_offset;
+        ranges[0][0] = entry ? data + entry->offset : data;
+        ranges[0][1] = data + seg->data_size;
+    } else if (maps[0].base && !seg) {
+        fprintf(stderr, "SweetEngine: Ignoring invalid history segment %s\n", SWEETEXP_HIST_SEGMENT_PATH);
+    }
+    // A .compacting log the segment already holds is left over from a crash
+    if (maps[1].base && !(seg && seg->consumed_inode == (uint64_t)maps[1].inode && seg->consumed_size == maps[1].size)) {
+        ranges[1][0] = maps[1].base;
+        ranges[1][1] = maps[1].base + maps[1].size;
+    }
+    if (maps[2].base) {
+        ranges[2][0] = maps[2].base;
+        ranges[2][1] = maps[2].base + maps[2].size;
+    }
+
+    int chunks = workers * BACKFILL_CHUNKS_PER_WORKER;
+    job.work = calloc((size_t)chunks * 4, sizeof(BackfillWork));
+    if (!job.work) {
+        for (int f = 0; f < 3; f++) backfill_unmap(&maps[f]);
+        return -1;
+    }
+    int64_t span = (job.now + 1 - job.from + chunks - 1) / chunks;
+    for (int c = 0; c < chunks; c++) {
+        BackfillWork* w = &job.work[job.work_count++];
+        w->from = job.from + span * c;
+        w->to = w->from + span < job.now + 1 ? w->from + span : job.now + 1;
+    }
+    for (int f = 0; f < 3; f++) {
+        if (ranges[f][0]) backfill_split_lines(&job, ranges[f][0], ranges[f][1], chunks);
+    }
+
+    pthread_t threads[BACKFILL_MAX_WORKERS];
+    int started = 0;
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&threads[started], NULL, backfill_worker, &job) == 0) started++;
+    }
+    if (started == 0) backfill_worker(&job);
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    for (int f = 0; f < 3; f++) backfill_unmap(&maps[f]);
+
+    // Reduce per shard in work-item order, then merge into live state
+    long applied = 0;
+    for (int s = 0; s < ACHIEVEMENT_SHARDS; s++) {
+        BackfillTable merged = {NULL, 0, 0};
+        for (int i = 0; i < job.work_count; i++) {
+            const BackfillTable* t = &job.work[i].table;
+            for (uint32_t k = 0; k < t->capacity; k++) {
+                const BackfillEntry* e = &t->entries[k];
+                if (!e->used || user_shard_index(e->user_id) != s) continue;
+                BackfillEntry* dst = backfill_entry(&merged, e->user_id, e->metric);
+                if (!dst) continue;
+                dst->counted |= e->counted;
+                dst->sum += e->sum;
+                for (int d = 0; d < ACTIVITY_DAY_WORDS; d++) dst->days[d] |= e->days[d];
+                for (int h = 0; h < ACTIVITY_HOUR_WORDS; h++) dst->hours[h] |= e->hours[h];
+            }
+        }
+        AchievementShard* shard = &engine.shards[s];
+        pthread_mutex_lock(&shard->lock);
+        for (uint32_t k = 0; k < merged.capacity; k++) {
+            if (merged.entries[k].used) {
+                backfill_apply_locked(shard, &merged.entries[k], job.now);
+                applied++;
+            }
+        }
+        pthread_mutex_unlock(&shard->lock);
+        free(merged.entries);
+    }
+    for (int i = 0; i < job.work_count; i++) free(job.work[i].table.entries);
+    free(job.work);
+
+    int unlocked = reevaluate_all_achievements();
+    log_engine_eventf("Backfill: %d days, %d workers, %ld user metrics replayed, %d achievements unlocked",
+                      days, workers, applied, unlocked);
+    return unlocked;
+}
+
+// ==================== PROC SAMPLER ====================
+// procfs never raises inotify events, so kernel activity is sampled instead. The
+// sources stay open for the life of the thread and are re-read with pread() at
+// offset 0 into one static buffer; the scanner below walks that buffer in place
+// (no stdio, no allocation). Each tick publishes one batch for the system user:
+// cpu_busy_pct and mem_used_pct as gauges (the metric tracks the latest value),
+// context_switches and the PSI "some" stall times as counters. A tick costs six
+// syscalls and a few KiB of parsing, cheap enough for PROC_SAMPLE_MS=100.
+
+enum {
+    PROC_STAT = 0,
+    PROC_MEMINFO,
+    PROC_PRESSURE_CPU,
+    PROC_PRESSURE_MEMORY,
+    PROC_PRESSURE_IO,
+    PROC_SOURCE_COUNT
+};
+
+static const char* const proc_source_paths[PROC_SOURCE_COUNT] = {
+    "/proc/stat", "/proc/meminfo",
+    "/proc/pressure/cpu", "/proc/pressure/memory", "/proc/pressure/io"
+};
+
+static const char* const proc_metric_names[PROC_SOURCE_COUNT + 1] = {
+    "cpu_busy_pct", "context_switches", "mem_used_pct",
+    "cpu_pressure_us", "mem_pressure_us", "io_pressure_us"
+};
+static const uint8_t proc_metric_gauge[PROC_SOURCE_COUNT + 1] = {1, 0, 1, 0, 0, 0};
+static int proc_metrics[PROC_SOURCE_COUNT + 1];
+
+typedef struct {
+    uint64_t cpu_busy;
+    uint64_t cpu_total;
+    uint64_t ctxt;
+    int64_t mem_used_pct;
+    uint64_t stall_us[3];       // cpu, memory, io
+} ProcSample;
+
+static char proc_buffer[PROC_SAMPLE_BUFFER];
+
+// Re-read a procfs file into proc_buffer; returns the end of the data or NULL
+static const char* proc_read(int fd) {
+    if (fd < 0) return NULL;
+    ssize_t len = pread(fd, proc_buffer, sizeof(proc_buffer) - 1, 0);
+    if (len <= 0) return NULL;
+    proc_buffer[len] = '\0';
+    return proc_buffer + len;
+}
+
+// Skip to the next digit and parse an unsigned decimal
+static uint64_t scan_u64(const char** cursor, const char* end) {
+    const char* p = *cursor;
+    uint64_t value = 0;
+    while (p < end && (*p < '0' || *p > '9') && *p != '\n') p++;
+    while (p < end && *p >= '0' && *p <= '9') value = value * 10 + (uint64_t)(*p++ - '0');
+    *cursor = p;
+    return value;
+}
+
+// Find a line starting with `key`; returns the position just after the key or NULL
+static const char* scan_line(const char* p, const char* end, const char* key, size_t key_len) {
+    while (p < end) {
+        if ((size_t)(end - p) >= key_len && memcmp(p, key, key_len) == 0) return p + key_len;
+        const char* nl = memchr(p, '\n', end - p);
+        if (!nl) break;
+        p = nl + 1;
+    }
+    return NULL;
+}
+
+static int proc_take_sample(const int* fds, ProcSample* out) {
+    const char* end = proc_read(fds[PROC_STAT]);
+    if (!end) return -1;
+
+    // cpu  user nice system idle iowait irq softirq steal ...
+    const char* p = scan_line(proc_buffer, end, "cpu ", 4);
+    if (!p) return -1;
+    uint64_t total = 0, idle = 0;
+    for (int field = 0; field < 8; field++) {
+        uint64_t v = scan_u64(&p, end);
+        total += v;
+        if (field == 3 || field == 4) idle += v;
+    }
+    out->cpu_total = total;
+    out->cpu_busy = total - idle;
+    p = scan_line(p, end, "ctxt ", 5);
+    out->ctxt = p ? scan_u64(&p, end) : 0;
+
+    out->mem_used_pct = 0;
+    if ((end = proc_read(fds[PROC_MEMINFO])) != NULL) {
+        const char* t = scan_line(proc_buffer, end, "MemTotal:", 9);
+        const char* a = scan_line(proc_buffer, end, "MemAvailable:", 13);
+        uint64_t mem_total = t ? scan_u64(&t, end) : 0;
+        uint64_t mem_avail = a ? scan_u64(&a, end) : 0;
+        if (mem_total > mem_avail) out->mem_used_pct = (int64_t)((mem_total - mem_avail) * 100 / mem_total);
+    }
+
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=12345
+    for (int i = 0; i < 3; i++) {
+        out->stall_us[i] = 0;
+        if ((end = proc_read(fds[PROC_PRESSURE_CPU + i])) == NULL) continue;
+        const char* nl = memchr(proc_buffer, '\n', end - proc_buffer);
+        const char* line_end = nl ? nl : end;
+        const char* q = proc_buffer;
+        while (q < line_end && (q = memchr(q, 't', line_end - q)) != NULL) {
+            if (line_end - q > 6 && memcmp(q, "total=", 6) == 0) {
+                q += 6;
+                out->stall_us[i] = scan_u64(&q, line_end);
+                break;
+            }
+            q++;
+        }
+    }
+    return 0;
+}
+
+static int proc_sample_interval_ms(void) {
+    int ms = engine.proc_sample_ms > 0 ? engine.proc_sample_ms : PROC_SAMPLE_DEFAULT_MS;
+    return ms < PROC_SAMPLE_MIN_MS ? PROC_SAMPLE_MIN_MS : ms;
+}
+
+// Register the sampler's metrics before anything (backfill) needs to know the gauges
+void init_proc_metrics(void) {
+    for (int i = 0; i < PROC_SOURCE_COUNT + 1; i++) {
+        proc_metrics[i] = proc_metric_gauge[i] ? register_gauge_metric(proc_metric_names[i])
+                                               : register_metric(proc_metric_names[i]);
+    }
+}
+
+// Kernel activity sampler (replaces the inotify watch on /proc/stat)
+void* proc_sampler_thread(void* arg) {
+    int fds[PROC_SOURCE_COUNT];
+
+    for (int i = 0; i < PROC_SOURCE_COUNT; i++) {
+        fds[i] = open(proc_source_paths[i], O_RDONLY | O_CLOEXEC);
+    }
+
+    ProcSample prev, cur;
+    if (proc_take_sample(fds, &prev) < 0) {
+        fprintf(stderr, "SweetEngine: /proc/stat unreadable, sampler disabled\n");
+        for (int i = 0; i < PROC_SOURCE_COUNT; i++) {
+            if (fds[i] >= 0) close(fds[i]);
+        }
+        return NULL;
+    }
+    int64_t busy_pct = 0;
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (engine.enabled) {
+        int ms = proc_sample_interval_ms();
+        next.tv_nsec += (long)(ms % 1000) * 1000000L;
+        next.tv_sec += ms / 1000 + next.tv_nsec / 1000000000L;
+        next.tv_nsec %= 1000000000L;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        if (proc_take_sample(fds, &cur) < 0) continue;
+
+        uint64_t total = cur.cpu_total - prev.cpu_total;
+        if (total) busy_pct = (int64_t)((cur.cpu_busy - prev.cpu_busy) * 100 / total);
+        int64_t values[PROC_SOURCE_COUNT + 1] = {
+            busy_pct,
+            (int64_t)(cur.ctxt - prev.ctxt),
+            cur.mem_used_pct,
+            (int64_t)(cur.stall_us[0] - prev.stall_us[0]),
+            (int64_t)(cur.stall_us[1] - prev.stall_us[1]),
+            (int64_t)(cur.stall_us[2] - prev.stall_us[2]),
+        };
+        prev = cur;
+
+        sweetexp_event batch[PROC_SOURCE_COUNT + 1];
+        uint32_t count = 0;
+        for (int i = 0; i < PROC_SOURCE_COUNT + 1; i++) {
+            if (proc_metrics[i] < 0 || (values[i] == 0 && !proc_metric_gauge[i])) continue;
+            batch[count].metric_id = (uint32_t)proc_metrics[i];
+            batch[count].user_id = SWEET_DEFAULT_USER_ID;
+            batch[count].delta = values[i];
+            batch[count].timestamp_ms = 0;
+            count++;
+        }
+        if (count) submit_metric_batch(batch, count);
+    }
+
+    for (int i = 0; i < PROC_SOURCE_COUNT; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    return NULL;
+}
+
+_Static_assert(ACTIVITY_DAY_WORDS == SWEETEXP_DATA_DAY_WORDS && ACTIVITY_HOUR_WORDS == SWEETEXP_DATA_HOUR_WORDS,
+               "activity bitmaps are stored verbatim");
+
+// Growable section buffer for the v2 data file
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    uint32_t count;
+} DataSection;
+
+static void* data_section_push(DataSection* sec, size_t len) {
+    if (sec->size + len > sec->capacity) {
+        size_t capacity = sec->capacity ? sec->capacity * 2 : 4096;
+        while (capacity < sec->size + len) capacity *= 2;
+        uint8_t* grown = realloc(sec->data, capacity);
+        if (!grown) return NULL;
+        sec->data = grown;
+        sec->capacity = capacity;
+    }
+    void* p = sec->data + sec->size;
+    memset(p, 0, len);
+    sec->size += len;
+    sec->count++;
+    return p;
+}
+
+// Intern a string in the string table; returns its offset
+static uint32_t data_string(DataSection* strings, const char* str) {
+    size_t len = strlen(str ? str : "") + 1;
+    uint32_t offset = (uint32_t)strings->size;
+    char* p = data_section_push(strings, len);
+    if (p) memcpy(p, str ? str : "", len);
+    return p ? offset : 0;
+}
+
+// Replace `path` with the given contents: write a temp file, fsync it, rename it
+// over `path` and fsync the directory, so a crash leaves either the old or the new
+// file, never a truncated one. Returns the number of fsyncs issued, or -1.
+static int atomic_write_file(const char* path, const struct iovec* iov, int iovcnt) {
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) total += iov[i].iov_len;
+    struct iovec rest[iovcnt > 0 ? iovcnt : 1];
+    memcpy(rest, iov, sizeof(struct iovec) * (size_t)iovcnt);
+    struct iovec* cur = rest;
+    int left = iovcnt;
+    while (total > 0) {
+        ssize_t n = writev(fd, cur, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        total -= (size_t)n;
+        // Skip fully written vectors after a short write
+        while (left > 0 && (size_t)n >= cur->iov_len) {
+            n -= (ssize_t)cur->iov_len;
+            cur++;
+            left--;
+        }
+        if (left > 0) {
+            cur->iov_base = (uint8_t*)cur->iov_base + n;
+            cur->iov_len -= (size_t)n;
+        }
+    }
+    if (total > 0 || fsync(fd) < 0) {
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    close(fd);
+    if (rename(tmp, path) < 0) {
+        unlink(tmp);
+        return -1;
+    }
+
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char* slash = strrchr(dir, '/');
+    if (slash) *slash = '\0';
+    int dir_fd = open(slash ? dir : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) return 1;
+    int fsyncs = fsync(dir_fd) == 0 ? 2 : 1;
+    close(dir_fd);
+    return fsyncs;
+}
+
+// Writer-owned copy of every user slot, the second buffer of the snapshot. A commit
+// refreshes only the copies whose user changed since (version moved), each a memcpy
+// under its shard lock, and serializes from the copies with no engine lock held, so
+// mutators stall for a few small copies instead of the whole encode. Commits never
+// overlap (see save_group), so the copies need no lock of their own.
+static struct {
+    UserAchievementState* copy;
+    const UserAchievementState* source;  // Live state `copy` was taken from, NULL if none
+} snapshot_users[ACHIEVEMENT_SHARDS][MAX_USERS_PER_SHARD];
+
+// Bring one shard's copies up to date and clear its dirty marks; -1 on allocation failure
+static int snapshot_shard(int s) {
+    AchievementShard* shard = &engine.shards[s];
+    int rc = 0;
+    pthread_mutex_lock(&shard->lock);
+    for (int slot = 0; slot < MAX_USERS_PER_SHARD; slot++) {
+        UserAchievementState* user = shard->users[slot];
+        if (!user) {
+            snapshot_users[s][slot].source = NULL;
+            continue;
+        }
+        if (!snapshot_users[s][slot].copy) snapshot_users[s][slot].copy = malloc(sizeof(UserAchievementState));
+        UserAchievementState* copy = snapshot_users[s][slot].copy;
+        if (!copy) {
+            rc = -1;
+            continue;
+        }
+        if (snapshot_users[s][slot].source != user || copy->version != user->version) {
+            memcpy(copy, user, sizeof(*copy));
+            snapshot_users[s][slot].source = user;
+        }
+        user->dirty = 0;
+    }
+    shard->dirty_users = 0;
+    pthread_mutex_unlock(&shard->lock);
+    return rc;
+}
+
+// Serialize engine state (format v2, see ENGINE DATA FILE in sweetexp_abi.h) and
+// commit it atomically; returns the number of fsyncs, or -1
+static int write_engine_data(void) {
+    DataSection sec[SWEETEXP_DATA_SECTIONS];
+    memset(sec, 0, sizeof(sec));
+    static const uint32_t record_sizes[SWEETEXP_DATA_SECTIONS] = {
+        sizeof(sweetexp_data_metric), sizeof(sweetexp_data_achievement), sizeof(sweetexp_data_progress),
+        sizeof(sweetexp_data_value), sizeof(sweetexp_data_activity), 1
+    };
+
+    // Take the snapshot: metric names are append-only and definitions change under
+    // every shard lock, so holding one is enough for a consistent definition list
+    static Achievement defs[MAX_ACHIEVEMENTS];
+    pthread_mutex_lock(&metric_lock);
+    int metrics = metric_count;
+    pthread_mutex_unlock(&metric_lock);
+    pthread_mutex_lock(&engine.shards[0].lock);
+    int achievement_count = engine.achievement_count;
+    memcpy(defs, engine.achievements, (size_t)achievement_count * sizeof(Achievement));
+    pthread_mutex_unlock(&engine.shards[0].lock);
+    for (int s = 0; s < ACHIEVEMENT_SHARDS; s++) {
+        if (snapshot_shard(s) < 0) {
+            fprintf(stderr, "SweetEngine: Out of memory taking snapshot\n");
+            return -1;  // The checkpoint keeps the journal, nothing is lost
+        }
+    }
+
+    // Encode from the copies; no engine lock is held from here on
+    data_string(&sec[SWEETEXP_DATA_STRINGS], "");  // Offset 0 = empty string
+    for (int m = 0; m < metrics; m++) {
+        sweetexp_data_metric* rec = data_section_push(&sec[SWEETEXP_DATA_METRICS], sizeof(*rec));
+        if (rec) rec->name = data_string(&sec[SWEETEXP_DATA_STRINGS], metric_names[m]);
+    }
+    for (int i = 0; i < achievement_count; i++) {
+        const Achievement* ach = &defs[i];
+        sweetexp_data_achievement* rec = data_section_push(&sec[SWEETEXP_DATA_ACHIEVEMENTS], sizeof(*rec));
+        if (!rec) continue;
+        rec->id = data_string(&sec[SWEETEXP_DATA_STRINGS], ach->id);
+        rec->name = data_string(&sec[SWEETEXP_DATA_STRINGS], ach->name);
+        rec->description = data_string(&sec[SWEETEXP_DATA_STRINGS], ach->description);
+        rec->target = ach->target;
+        rec->metric = ach->metric;
+        rec->kind = ach->kind;
+    }
+
+    for (int s = 0; s < ACHIEVEMENT_SHARDS; s++) {
+        for (int slot = 0; slot < MAX_USERS_PER_SHARD; slot++) {
+            if (!snapshot_users[s][slot].source) continue;
+            const UserAchievementState* user = snapshot_users[s][slot].copy;
+            for (int m = 0; m < metrics; m++) {
+                if (user->metrics[m] != 0) {
+                    sweetexp_data_value* rec = data_section_push(&sec[SWEETEXP_DATA_VALUES], sizeof(*rec));
+                    if (rec) *rec = (sweetexp_data_value){user->user_id, (uint32_t)m, user->metrics[m]};
+                }
+                const ActivityBitmap* a = &user->activity[m];
+                if (a->last_day) {
+                    sweetexp_data_activity* rec = data_section_push(&sec[SWEETEXP_DATA_ACTIVITY], sizeof(*rec));
+                    if (!rec) continue;
+                    rec->user_id = user->user_id;
+                    rec->metric = (uint32_t)m;
+                    rec->last_day = a->last_day;
+                    rec->last_hour = a->last_hour;
+                    memcpy(rec->days, a->days, sizeof(rec->days));
+                    memcpy(rec->hours, a->hours, sizeof(rec->hours));
+                }
+            }
+            for (int i = 0; i < achievement_count; i++) {
+                const AchievementProgress* p = &user->progress[i];
+                if (p->progress == 0 && !p->unlocked) continue;
+                sweetexp_data_progress* rec = data_section_push(&sec[SWEETEXP_DATA_PROGRESS], sizeof(*rec));
+                if (rec) *rec = (sweetexp_data_progress){user->user_id, (uint32_t)i, p->progress,
+                                                         (uint32_t)p->unlocked, (int64_t)p->unlock_time};
+            }
+        }
+    }
+
+    // Lay the sections out after the header, 8-byte aligned, and checksum the body
+    sweetexp_data_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SWEETEXP_DATA_MAGIC, sizeof(header.magic));
+    header.version = SWEETEXP_DATA_VERSION;
+    header.header_size = sizeof(header);
+    uint64_t offset = sizeof(header);
+    uint32_t crc = 0;
+    static const uint8_t zero_pad[8];
+    for (int i = 0; i < SWEETEXP_DATA_SECTIONS; i++) {
+        header.sections[i].offset = offset;
+        header.sections[i].count = i == SWEETEXP_DATA_STRINGS ? (uint32_t)sec[i].size : sec[i].count;
+        header.sections[i].record_size = record_sizes[i];
+        crc = sweetexp_crc32(crc, sec[i].data, sec[i].size);
+        offset += sec[i].size;
+        if (offset % 8) {
+            crc = sweetexp_crc32(crc, zero_pad, 8 - offset % 8);
+            offset += 8 - offset % 8;
+        }
+    }
+    header.file_size = offset;
+    header.crc32 = crc;
+
+    struct iovec iov[1 + 2 * SWEETEXP_DATA_SECTIONS];
+    int n = 0;
+    iov[n++] = (struct iovec){&header, sizeof(header)};
+    for (int i = 0; i < SWEETEXP_DATA_SECTIONS; i++) {
+        if (sec[i].size) iov[n++] = (struct iovec){sec[i].data, sec[i].size};
+        uint64_t end = header.sections[i].offset + sec[i].size;
+        if (end % 8) iov[n++] = (struct iovec){(void*)zero_pad, 8 - end % 8};
+    }
+    int rc = atomic_write_file(SWEETEXP_DATA_PATH, iov, n);
+
+    for (int i = 0; i < SWEETEXP_DATA_SECTIONS; i++) free(sec[i].data);
+    if (rc < 0) fprintf(stderr, "SweetEngine: Failed to write %s: %s\n", SWEETEXP_DATA_PATH, strerror(errno));
+    return rc;
+}
+
+static int journal_begin_checkpoint(void);
+static void journal_end_checkpoint(int rotated, int ok);
+
+// Group commit: a caller's save is durable once a commit that started after its
+// request finishes. The first caller to find no commit running becomes the writer;
+// if other saves are already queued it waits SAVE_GROUP_WINDOW_MS for more to join,
+// then takes one snapshot covering every request made so far; callers arriving
+// meanwhile wait and are covered by the next commit. A burst of unlocks therefore
+// costs a couple of fsyncs, not one pair per unlock, and a lone save pays no window.
+// Each caller queues a SaveWaiter and gets the result of the commit that covered it.
+// Commit latency and fsyncs go to the save_latency_us and save_fsyncs rollup metrics.
+typedef struct SaveWaiter {
+    uint64_t ticket;
+    int rc;                         // SAVE_PENDING until a commit covers the ticket
+    struct SaveWaiter* next;
+} SaveWaiter;
+
+#define SAVE_PENDING 1
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    uint64_t requested;
+    SaveWaiter* waiters;            // Requests no commit has covered yet
+    int writing;
+    int latency_metric;
+    int fsync_metric;
+} save_group = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, NULL, 0, -1, -1};
+
+// Save engine state durably; returns 0 once a commit covering this call succeeded
+int save_engine_data(void) {
+    pthread_mutex_lock(&save_group.lock);
+    SaveWaiter self = {++save_group.requested, SAVE_PENDING, save_group.waiters};
+    save_group.waiters = &self;
+    while (self.rc == SAVE_PENDING) {
+        if (save_group.writing) {
+            pthread_cond_wait(&save_group.done, &save_group.lock);
+            continue;
+        }
+        save_group.writing = 1;
+        int others = save_group.waiters != &self || self.next != NULL;
+        pthread_mutex_unlock(&save_group.lock);
+
+        if (others) {
+            struct timespec window = {0, SAVE_GROUP_WINDOW_MS * 1000000L};
+            nanosleep(&window, NULL);
+        }
+        pthread_mutex_lock(&save_group.lock);
+        uint64_t covered = save_group.requested;
+        pthread_mutex_unlock(&save_group.lock);
+
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        int rotated = journal_begin_checkpoint();
+        int fsyncs = write_engine_data();
+        journal_end_checkpoint(rotated, fsyncs >= 0);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        if (save_group.latency_metric < 0) {
+            save_group.latency_metric = register_metric("save_latency_us");
+            save_group.fsync_metric = register_metric("save_fsyncs");
+        }
+        record_metric_sample(save_group.latency_metric,
+                             (int64_t)(t1.tv_sec - t0.tv_sec) * 1000000 + (t1.tv_nsec - t0.tv_nsec) / 1000);
+        if (fsyncs > 0) record_metric_sample(save_group.fsync_metric, fsyncs);
+
+        pthread_mutex_lock(&save_group.lock);
+        for (SaveWaiter** link = &save_group.waiters; *link;) {
+            SaveWaiter* w = *link;
+            if (w->ticket <= covered) {
+                w->rc = fsyncs < 0 ? -1 : 0;
+                *link = w->next;
+            } else {
+                link = &w->next;
+            }
+        }
+        save_group.writing = 0;
+        pthread_cond_broadcast(&save_group.done);
+    }
+    int rc = self.rc;
+    pthread_mutex_unlock(&save_group.lock);
+    return rc;
+}
+
+// Seed one user's progress from a persisted record
+static void load_user_progress(int user_id, int idx, int progress, int unlocked, long unlock_time) {
+    AchievementShard* shard = &engine.shards[user_shard_index(user_id)];
+    pthread_mutex_lock(&shard->lock);
+    UserAchievementState* user = shard_find_user_locked(shard, user_id, 1);
+    if (user) {
+        user->progress[idx].progress = progress;
+        user->progress[idx].unlocked = unlocked;
+        user->progress[idx].unlock_time = (time_t)unlock_time;
+        publish_progress_locked(user, &user->progress[idx], idx);
+        shard_touch_locked(user);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// Restore one STK:uid|metric|last_day|last_hour|day words|hour words line (hex words)
+static void load_activity(const char* rec) {
+    char key[64];
+    int user_id, last_day, last_hour, used = 0;
+    if (sscanf(rec, "%d|%63[^|]|%d|%d|%n", &user_id, key, &last_day, &last_hour, &used) != 4 || !used) return;
+    int metric = register_metric(key);
+    if (metric < 0) return;
+
+    ActivityBitmap a = {last_day, last_hour, {0}, {0}};
+    char* p = (char*)rec + used;
+    for (int w = 0; w < ACTIVITY_DAY_WORDS + ACTIVITY_HOUR_WORDS; w++) {
+        uint64_t v = strtoull(p, &p, 16);
+        if (w < ACTIVITY_DAY_WORDS) a.days[w] = v;
+        else a.hours[w - ACTIVITY_DAY_WORDS] = v;
+        if (*p != ',' && *p != '|') break;
+        p++;
+    }
+
+    AchievementShard* shard = &engine.shards[user_shard_index(user_id)];
+    pthread_mutex_lock(&shard->lock);
+    UserAchievementState* user = shard_find_user_locked(shard, user_id, 1);
+    if (user) {
+        user->activity[metric] = a;
+        shard_touch_locked(user);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// Add a custom achievement definition unless its id is already known
+static int load_achievement_definition(const char* id, const char* name, const char* description,
+                                       int target, int metric, int kind) {
+    int idx = find_achievement_index(id);
+    if (idx >= 0 || engine.achievement_count >= MAX_ACHIEVEMENTS) return idx;
+    idx = engine.achievement_count++;
+    Achievement* custom = &engine.achievements[idx];
+    memset(custom, 0, sizeof(*custom));
+    custom->id = strdup(id);
+    custom->name = strdup(name);
+    custom->description = strdup(description);
+    custom->target = target;
+    custom->metric = metric;
+    custom->kind = metric >= 0 ? kind : ACHIEVEMENT_TOTAL;
+    return idx;
+}
+
+// Restore one metric value and its leaderboard entry
+static void load_metric_value(int user_id, int metric, int64_t value) {
+    if (metric < 0) return;
+    AchievementShard* shard = &engine.shards[user_shard_index(user_id)];
+    pthread_mutex_lock(&shard->lock);
+    UserAchievementState* user = shard_find_user_locked(shard, user_id, 1);
+    if (user) {
+        user->metrics[metric] = value;
+        leaderboard_update_locked(user, metric);
+        shard_touch_locked(user);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// Format v1: line records, default-user progress on the ACH lines
+static int load_engine_data_v1(FILE* fp) {
+    char line[512];
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "ACH:", 4) != 0) continue;
+
+        char id[32], name[64], description[128], metric[64] = "";
+        int progress, target, unlocked = 0, kind = ACHIEVEMENT_TOTAL;
+        long unlock_time = 0;
+        int fields = sscanf(line + 4, "%31[^|]|%63[^|]|%127[^|]|%d|%d|%d|%ld|%63[^|\n]|%d",
+                            id, name, description, &progress, &target, &unlocked, &unlock_time, metric, &kind);
+        if (fields < 5) continue;
+
+        int idx = find_achievement_index(id);
+        if (idx < 0) {
+            idx = load_achievement_definition(id, name, description, target,
+                                              fields >= 8 && strcmp(metric, "-") != 0 ? register_metric(metric) : -1,
+                                              fields == 9 ? kind : ACHIEVEMENT_TOTAL);
+            if (idx < 0) continue;
+        }
+        engine.achievements[idx].progress = progress;
+        engine.achievements[idx].unlocked = unlocked;
+        engine.achievements[idx].unlock_time = (time_t)unlock_time;
+    }
+    rebuild_metric_index();
+    
+    // Distribute per-user state to the owning shards
+    for (int i = 0; i < engine.achievement_count; i++) {
+        Achievement* ach = &engine.achievements[i];
+        if (ach->progress || ach->unlocked) {
+            load_user_progress(SWEET_DEFAULT_USER_ID, i, ach->progress, ach->unlocked, (long)ach->unlock_time);
+        }
+    }
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp)) {
+        int user_id, progress, unlocked;
+        long unlock_time;
+        long long value;
+        char key[64];
+        if (strncmp(line, "USR:", 4) == 0 &&
+            sscanf(line + 4, "%d|%63[^|]|%d|%d|%ld", &user_id, key, &progress, &unlocked, &unlock_time) == 5) {
+            int idx = find_achievement_index(key);
+            if (idx >= 0) load_user_progress(user_id, idx, progress, unlocked, unlock_time);
+        } else if (strncmp(line, "MET:", 4) == 0 &&
+                   sscanf(line + 4, "%d|%63[^|]|%lld", &user_id, key, &value) == 3) {
+            load_metric_value(user_id, register_metric(key), value);
+        } else if (strncmp(line, "STK:", 4) == 0) {
+            load_activity(line + 4);
+        }
+    }
+    return 0;
+}
+
+// Bounds-checked view of one section: its first record, or NULL if it does not fit
+static const uint8_t* data_section_base(const uint8_t* base, size_t size, int index, uint32_t min_record) {
+    const sweetexp_data_section* sec = &((const sweetexp_data_header*)base)->sections[index];
+    if (sec->record_size < min_record || sec->offset > size) return NULL;
+    if ((uint64_t)sec->count * sec->record_size > size - sec->offset) return NULL;
+    return base + sec->offset;
+}
+
+// String at `off` in the strings section; out-of-range offsets read as ""
+static inline const char* data_string_at(const char* strings, uint32_t strings_size, uint32_t off) {
+    return off < strings_size ? strings + off : "";
+}
+
+// Format v2: fixed-width records read in place from the mapped file
+static int load_engine_data_v2(const uint8_t* base, size_t size) {
+    const sweetexp_data_header* h = (const sweetexp_data_header*)base;
+    if (size < sizeof(*h) || h->version != SWEETEXP_DATA_VERSION || h->header_size < sizeof(*h) ||
+        h->file_size != size || h->crc32 != sweetexp_crc32(0, base + h->header_size, size - h->header_size)) {
+        fprintf(stderr, "SweetEngine: %s is corrupt, starting from defaults\n", SWEETEXP_DATA_PATH);
+        return -1;
+    }
+    const sweetexp_data_section* sections = h->sections;
+    const uint8_t* metrics = data_section_base(base, size, SWEETEXP_DATA_METRICS, sizeof(sweetexp_data_metric));
+    const uint8_t* achs = data_section_base(base, size, SWEETEXP_DATA_ACHIEVEMENTS, sizeof(sweetexp_data_achievement));
+    const uint8_t* progress = data_section_base(base, size, SWEETEXP_DATA_PROGRESS, sizeof(sweetexp_data_progress));
+    const uint8_t* values = data_section_base(base, size, SWEETEXP_DATA_VALUES, sizeof(sweetexp_data_value));
+    const uint8_t* activity = data_section_base(base, size, SWEETEXP_DATA_ACTIVITY, sizeof(sweetexp_data_activity));
+    const char* strings = (const char*)data_section_base(base, size, SWEETEXP_DATA_STRINGS, 1);
+    uint32_t strings_size = sections[SWEETEXP_DATA_STRINGS].count;
+    if (!metrics || !achs || !progress || !values || !activity || !strings ||
+        strings_size == 0 || strings[strings_size - 1] != '\0') {
+        fprintf(stderr, "SweetEngine: %s has a bad section table\n", SWEETEXP_DATA_PATH);
+        return -1;
+    }
+    // File metric/achievement indexes -> live ids
+    uint32_t metric_total = sections[SWEETEXP_DATA_METRICS].count;
+    uint32_t ach_total = sections[SWEETEXP_DATA_ACHIEVEMENTS].count;
+    int* metric_map = malloc((metric_total + 1) * sizeof(int));
+    int* ach_map = malloc((ach_total + 1) * sizeof(int));
+    if (!metric_map || !ach_map) {
+        free(metric_map);
+        free(ach_map);
+        return -1;
+    }
+    for (uint32_t i = 0; i < metric_total; i++) {
+        const sweetexp_data_metric* rec = (const void*)(metrics + (size_t)i * sections[SWEETEXP_DATA_METRICS].record_size);
+        metric_map[i] = register_metric(data_string_at(strings, strings_size, rec->name));
+    }
+    for (uint32_t i = 0; i < ach_total; i++) {
+        const sweetexp_data_achievement* rec =
+            (const void*)(achs + (size_t)i * sections[SWEETEXP_DATA_ACHIEVEMENTS].record_size);
+        int metric = rec->metric >= 0 && (uint32_t)rec->metric < metric_total ? metric_map[rec->metric] : -1;
+        ach_map[i] = load_achievement_definition(data_string_at(strings, strings_size, rec->id),
+                                                 data_string_at(strings, strings_size, rec->name),
+                                                 data_string_at(strings, strings_size, rec->description),
+                                                 rec->target, metric, rec->kind);
+    }
+    rebuild_metric_index();
+
+    for (uint32_t i = 0; i < sections[SWEETEXP_DATA_PROGRESS].count; i++) {
+        const sweetexp_data_progress* rec =
+            (const void*)(progress + (size_t)i * sections[SWEETEXP_DATA_PROGRESS].record_size);
+        if (rec->achievement >= ach_total || ach_map[rec->achievement] < 0) continue;
+        load_user_progress(rec->user_id, ach_map[rec->achievement], rec->progress, (int)rec->unlocked,
+                           (long)rec->unlock_time);
+    }
+    for (uint32_t i = 0; i < sections[SWEETEXP_DATA_VALUES].count; i++) {
+        const sweetexp_data_value* rec = (const void*)(values + (size_t)i * sections[SWEETEXP_DATA_VALUES].record_size);
+        if (rec->metric < metric_total) load_metric_value(rec->user_id, metric_map[rec->metric], rec->value);
+    }
+    for (uint32_t i = 0; i < sections[SWEETEXP_DATA_ACTIVITY].count; i++) {
+        const sweetexp_data_activity* rec =
+            (const void*)(activity + (size_t)i * sections[SWEETEXP_DATA_ACTIVITY].record_size);
+        if (rec->metric >= metric_total || metric_map[rec->metric] < 0) continue;
+        AchievementShard* shard = &engine.shards[user_shard_index(rec->user_id)];
+        pthread_mutex_lock(&shard->lock);
+        UserAchievementState* user = shard_find_user_locked(shard, rec->user_id, 1);
+        if (user) {
+            ActivityBitmap* a = &user->activity[metric_map[rec->metric]];
+            a->last_day = rec->last_day;
+            a->last_hour = rec->last_hour;
+            memcpy(a->days, rec->days, sizeof(a->days));
+            memcpy(a->hours, rec->hours, sizeof(a->hours));
+            shard_touch_locked(user);
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    free(metric_map);
+    free(ach_map);
+    return 0;
+}
+
+// Load the last checkpoint and replay the journal; a v1 text file is migrated to
+// v2 (original kept as .v1)
+int load_engine_data(void) {
+    // Built-ins come from the catalogue; the file adds custom definitions and progress
+    memcpy(engine.achievements, builtin_achievements, sizeof(builtin_achievements));
+    engine.achievement_count = BUILTIN_ACHIEVEMENT_COUNT;
+
+    int fd = open(SWEETEXP_DATA_PATH, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0 || st.st_size == 0) {
+        if (fd >= 0) close(fd);
+        rebuild_metric_index();
+        journal_open();
+        return -1;
+    }
+
+    char magic[sizeof(((sweetexp_data_header*)0)->magic)] = {0};
+    if (pread(fd, magic, sizeof(magic), 0) == (ssize_t)sizeof(magic) &&
+        memcmp(magic, SWEETEXP_DATA_MAGIC, sizeof(magic)) == 0) {
+        void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            rebuild_metric_index();
+            journal_open();
+            return -1;
+        }
+        int rc = load_engine_data_v2(base, (size_t)st.st_size);
+        munmap(base, (size_t)st.st_size);
+        if (rc < 0) {
+            // Keep the damaged file for inspection rather than overwrite it on the next save
+            rename(SWEETEXP_DATA_PATH, SWEETEXP_DATA_PATH ".corrupt");
+            rebuild_metric_index();
+        }
+        journal_open();  // Replays mutations made after the last checkpoint
+        return rc;
+    }
+
+    FILE* fp = fdopen(fd, "r");
+    if (!fp) {
+        close(fd);
+        rebuild_metric_index();
+        return -1;
+    }
+    load_engine_data_v1(fp);
+    fclose(fp);
+    journal_open();
+    // Hard-link the v1 file aside first: the v2 save then renames over the main
+    // path, so a crash or failed save at any point leaves a loadable file there
+    if (link(SWEETEXP_DATA_PATH, SWEETEXP_DATA_PATH ".v1.tmp") == 0 &&
+        rename(SWEETEXP_DATA_PATH ".v1.tmp", SWEETEXP_DATA_PATH ".v1") == 0 && save_engine_data() == 0) {
+        log_engine_event("Engine data migrated from v1 to v2");
+    } else {
+        unlink(SWEETEXP_DATA_PATH ".v1.tmp");
+    }
+    return 0;
+}
+
+// ==================== ENGINE LOG ====================
+// Engine events go through the shared Lumen logger (LumenLog.c, also used by
+// BootSecurityManager): the caller formats into its thread's staging buffer and
+// the process's flusher appends to engine.log in batched writes. LOG_OVERFLOW in
+// sweetexpengine.ini (drop, block, sync) picks what a full staging buffer does.
+// LOG_FORMAT=binary stages only the format and arguments and writes engine.lbin
+// instead, for lumenlog_decode to render. Until start_engine_logger() and after
+// stop_engine_logger() events are written directly to the attached sinks; before
+// init_engine_logger() attaches the file there are none, so those events are lost.
+
+// Log engine events
+void log_engine_event(const char* event) {
+    lumenlog_write(LUMENLOG_INFO, ENGINE_LOG_TAG, "%s", event);
+}
+
+// Called through log_engine_eventf(), which only accepts a string literal: binary
+// mode keeps the format pointer until the flush
+void log_engine_event_format(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    lumenlog_vwrite(LUMENLOG_INFO, ENGINE_LOG_TAG, fmt, args);
+    va_end(args);
+}
+
+// Attach engine.log, or engine.lbin with LOG_FORMAT=binary; events logged
+// before this reach no sink and are lost
+void init_engine_logger(void) {
+    static int attached;
+    if (attached) return;
+    const char* path = engine.log_binary ? SWEETEXP_ENGINE_BINLOG_PATH : SWEETEXP_ENGINE_LOG_PATH;
+    lumenlog_sink* file = engine.log_binary ? lumenlog_binary_file_sink(path) : lumenlog_file_sink(path);
+    if (!file || lumenlog_add_sink(file) < 0) {
+        fprintf(stderr, "SweetEngine: Cannot open %s: %s\n", path, strerror(errno));
+        return;
+    }
+    lumenlog_set_binary(engine.log_binary);
+    attached = 1;
+}
+
+int start_engine_logger(void) {
+    init_engine_logger();
+    return lumenlog_start();
+}
+
+// Write what is staged, then stop; later events are written directly to the file
+void stop_engine_logger(void) {
+    lumenlog_stop();
+}
+
+// ==================== WRITE-AHEAD JOURNAL ====================
+// Mutations are appended to SWEETEXP_JOURNAL_PATH as small CRC-protected records
+// instead of rewriting the whole data file: the final value of each (user, metric)
+// pair touched by a batch, unlocks, and achievement definitions. Metric records
+// carry the writer's metric ids, so each journal segment starts with METRIC_DEF
+// records naming them (and new registrations add one). Records collect in a 64 KiB
+// buffer; journal_sync() writes it and fdatasyncs, which the persistence writer
+// does right after unlocks and on every monitor check. A checkpoint (every
+// save_engine_data()) first moves the journal aside to .prev, appending it to a
+// .prev a failed checkpoint left, and starts a new one; it then writes the
+// snapshot and deletes .prev, since everything in .prev was applied before the
+// snapshot was taken.
+// Recovery loads the snapshot and replays .prev (if a checkpoint failed) and the
+// journal in order. Records set absolute values, so replaying one the snapshot
+// already contains is harmless; a torn tail is detected by CRC and cut off.
+
+enum {
+    JOURNAL_METRIC_DEF = 1,
+    JOURNAL_METRIC = 2,
+    JOURNAL_UNLOCK = 3,
+    JOURNAL_DEFINE = 4
+};
+
+typedef struct {
+    uint32_t crc;                   // Over type, size and payload
+    uint16_t type;
+    uint16_t size;                  // Payload bytes
+} JournalHeader;
+
+typedef struct {
+    uint32_t metric;
+    char name[SWEETEXP_ROLLUP_NAME_LEN];
+} JournalMetricDef;
+
+typedef struct {
+    int32_t user_id;
+    uint32_t metric;
+    int64_t value;
+    int64_t active_at;              // Latest active hour (unix sec), 0 if none
+} JournalMetric;
+
+typedef struct {
+    int32_t user_id;
+    int32_t reserved;
+    int64_t unlock_time;
+    char id[32];
+} JournalUnlock;
+
+typedef struct {
+    int32_t target;
+    int32_t metric;                 // Metric id as named by METRIC_DEF, -1 = manual
+    int32_t kind;
+    char id[32];
+    char name[64];
+    char description[128];
+} JournalDefine;
+
+static struct {
+    pthread_mutex_t lock;           // Buffer and fd; a leaf lock (taken under shard locks)
+    pthread_mutex_t sync_lock;      // Serializes syncs and segment switches
+    int fd;
+    int unsynced;
+    size_t used;
+    uint64_t bytes;                 // Current segment size including the buffer
+    uint8_t buffer[JOURNAL_BUFFER_SIZE];
+} journal = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, -1, 0, 0, 0, {0}};
+
+static void journal_write_locked(void) {
+    size_t off = 0;
+    while (off < journal.used) {
+        ssize_t n = write(journal.fd, journal.buffer + off, journal.used - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        off += (size_t)n;
+    }
+    journal.used = 0;
+}
+
+static void journal_append_locked(uint16_t type, const void* payload, uint16_t size) {
+    JournalHeader h = {0, type, size};
+    h.crc = sweetexp_crc32(sweetexp_crc32(0, &h.type, sizeof(h) - sizeof(h.crc)), payload, size);
+
+    if (journal.fd >= 0) {
+        if (journal.used + sizeof(h) + size > sizeof(journal.buffer)) journal_write_locked();
+        memcpy(journal.buffer + journal.used, &h, sizeof(h));
+        memcpy(journal.buffer + journal.used + sizeof(h), payload, size);
+        journal.used += sizeof(h) + size;
+        journal.bytes += sizeof(h) + size;
+        journal.unsynced = 1;
+    }
+}
+
+static void journal_append(uint16_t type, const void* payload, uint16_t size) {
+    pthread_mutex_lock(&journal.lock);
+    journal_append_locked(type, payload, size);
+    pthread_mutex_unlock(&journal.lock);
+}
+
+// Called with metric_lock and journal.lock held
+static void journal_define_metric_locked(int metric_id, const char* name) {
+    JournalMetricDef rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.metric = (uint32_t)metric_id;
+    strncpy(rec.name, name, sizeof(rec.name) - 1);
+    journal_append_locked(JOURNAL_METRIC_DEF, &rec, sizeof(rec));
+}
+
+// Called with metric_lock held
+static void journal_define_metric(int metric_id, const char* name) {
+    pthread_mutex_lock(&journal.lock);
+    journal_define_metric_locked(metric_id, name);
+    pthread_mutex_unlock(&journal.lock);
+}
+
+static void journal_define_all_metrics(void) {
+    pthread_mutex_lock(&metric_lock);
+    for (int m = 0; m < metric_count; m++) journal_define_metric(m, metric_names[m]);
+    pthread_mutex_unlock(&metric_lock);
+}
+
+void journal_record_metric(int user_id, int metric_id, int64_t value, int64_t active_at) {
+    JournalMetric rec = {user_id, (uint32_t)metric_id, value, active_at};
+    journal_append(JOURNAL_METRIC, &rec, sizeof(rec));
+}
+
+void journal_record_unlock(int user_id, const char* id, time_t unlock_time) {
+    JournalUnlock rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.user_id = user_id;
+    rec.unlock_time = (int64_t)unlock_time;
+    strncpy(rec.id, id, sizeof(rec.id) - 1);
+    journal_append(JOURNAL_UNLOCK, &rec, sizeof(rec));
+}
+
+static void journal_record_define(const Achievement* ach) {
+    JournalDefine rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.target = ach->target;
+    rec.metric = ach->metric;
+    rec.kind = ach->kind;
+    strncpy(rec.id, ach->id, sizeof(rec.id) - 1);
+    strncpy(rec.name, ach->name, sizeof(rec.name) - 1);
+    strncpy(rec.description, ach->description, sizeof(rec.description) - 1);
+    journal_append(JOURNAL_DEFINE, &rec, sizeof(rec));
+}
+
+// Write buffered records and make them durable; fdatasync runs without the
+// append lock so shard holders are never stalled behind the disk
+int journal_sync(void) {
+    pthread_mutex_lock(&journal.sync_lock);
+    pthread_mutex_lock(&journal.lock);
+    int fd = journal.fd;
+    int pending = journal.unsynced;
+    if (fd >= 0 && journal.used > 0) journal_write_locked();
+    journal.unsynced = 0;
+    pthread_mutex_unlock(&journal.lock);
+    int rc = fd >= 0 && pending ? fdatasync(fd) : 0;
+    pthread_mutex_unlock(&journal.sync_lock);
+    return rc;
+}
+
+uint64_t journal_size(void) {
+    pthread_mutex_lock(&journal.lock);
+    uint64_t bytes = journal.bytes;
+    pthread_mutex_unlock(&journal.lock);
+    return bytes;
+}
+
+// Append the current segment to the .prev a failed checkpoint left and make it
+// durable (journal.lock held). Replaying a record twice is harmless, so a crash
+// before the caller empties the segment loses nothing.
+static int journal_fold_into_prev_locked(void) {
+    int in = open(SWEETEXP_JOURNAL_PATH, O_RDONLY | O_CLOEXEC);
+    int out = open(SWEETEXP_JOURNAL_PATH ".prev", O_WRONLY | O_APPEND | O_CLOEXEC);
+    int rc = in >= 0 && out >= 0 ? 0 : -1;
+    uint8_t chunk[16384];
+    while (rc == 0) {
+        ssize_t n = read(in, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            rc = n < 0 ? -1 : 0;
+            break;
+        }
+        for (ssize_t off = 0; off < n;) {
+            ssize_t w = write(out, chunk + off, (size_t)(n - off));
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) {
+                rc = -1;
+                break;
+            }
+            off += w;
+        }
+    }
+    if (rc == 0 && fdatasync(out) < 0) rc = -1;
+    if (in >= 0) close(in);
+    if (out >= 0) close(out);
+    return rc;
+}
+
+// Start a new segment ahead of a snapshot; returns 1 if the old one moved to .prev.
+// A .prev left by a failed checkpoint takes the current segment's records too, so
+// every record written before the snapshot is retired with it; otherwise replay
+// could roll back state changed without journaling (loads, backfill). metric_lock
+// and journal.lock are held from the switch until the new segment's METRIC_DEF
+// records are in, so no metric record can precede them.
+static int journal_begin_checkpoint(void) {
+    int rotated = 0;
+    pthread_mutex_lock(&journal.sync_lock);
+    pthread_mutex_lock(&metric_lock);  // Before journal.lock, as in register_metric()
+    pthread_mutex_lock(&journal.lock);
+    if (journal.fd >= 0) {
+        journal_write_locked();
+        fdatasync(journal.fd);
+        journal.unsynced = 0;
+        if (access(SWEETEXP_JOURNAL_PATH ".prev", F_OK) == 0) {
+            if (journal_fold_into_prev_locked() == 0 && ftruncate(journal.fd, 0) == 0) {
+                journal.bytes = 0;
+                rotated = 1;
+            }
+        } else if (rename(SWEETEXP_JOURNAL_PATH, SWEETEXP_JOURNAL_PATH ".prev") == 0) {
+            close(journal.fd);
+            journal.fd = open(SWEETEXP_JOURNAL_PATH, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+            journal.bytes = 0;
+            rotated = 1;
+        }
+        if (rotated) {
+            for (int m = 0; m < metric_count; m++) journal_define_metric_locked(m, metric_names[m]);
+        }
+    }
+    pthread_mutex_unlock(&journal.lock);
+    pthread_mutex_unlock(&metric_lock);
+    pthread_mutex_unlock(&journal.sync_lock);
+    return rotated;
+}
+
+static void journal_end_checkpoint(int rotated, int ok) {
+    if (ok && rotated) unlink(SWEETEXP_JOURNAL_PATH ".prev");
+}
+
+// Apply one record during recovery; `metric_map` maps journal metric ids
+static void journal_apply(uint16_t type, const uint8_t* payload, uint16_t size, int* metric_map) {
+    if (type == JOURNAL_METRIC_DEF && size >= sizeof(JournalMetricDef)) {
+        JournalMetricDef rec;
+        memcpy(&rec, payload, sizeof(rec));
+        rec.name[sizeof(rec.name) - 1] = '\0';
+        if (rec.metric < MAX_METRICS) metric_map[rec.metric] = register_metric(rec.name);
+    } else if (type == JOURNAL_METRIC && size >= sizeof(JournalMetric)) {
+        JournalMetric rec;
+        memcpy(&rec, payload, sizeof(rec));
+        if (rec.metric >= MAX_METRICS || metric_map[rec.metric] < 0) return;
+        load_metric_value(rec.user_id, metric_map[rec.metric], rec.value);
+        if (rec.active_at > 0) {
+            AchievementShard* shard = &engine.shards[user_shard_index(rec.user_id)];
+            pthread_mutex_lock(&shard->lock);
+            UserAchievementState* user = shard_find_user_locked(shard, rec.user_id, 1);
+            if (user) {
+                activity_mark(&user->activity[metric_map[rec.metric]], rec.active_at);
+                shard_touch_locked(user);
+            }
+            pthread_mutex_unlock(&shard->lock);
+        }
+    } else if (type == JOURNAL_UNLOCK && size >= sizeof(JournalUnlock)) {
+        JournalUnlock rec;
+        memcpy(&rec, payload, sizeof(rec));
+        rec.id[sizeof(rec.id) - 1] = '\0';
+        int idx = find_achievement_index(rec.id);
+        if (idx >= 0) load_user_progress(rec.user_id, idx, engine.achievements[idx].target, 1, (long)rec.unlock_time);
+    } else if (type == JOURNAL_DEFINE && size >= sizeof(JournalDefine)) {
+        JournalDefine rec;
+        memcpy(&rec, payload, sizeof(rec));
+        rec.id[sizeof(rec.id) - 1] = rec.name[sizeof(rec.name) - 1] = rec.description[sizeof(rec.description) - 1] = '\0';
+        int metric = rec.metric >= 0 && rec.metric < MAX_METRICS ? metric_map[rec.metric] : -1;
+        if (builtin_achievement_index(rec.id) < 0 &&
+            apply_achievement_definition(rec.id, rec.name, rec.description, rec.target, metric, rec.kind) >= 0) {
+            rebuild_metric_index();
+        }
+    }
+}
+
+// Replay one segment; returns records applied. With `repair`, a torn or corrupt
+// tail is truncated so new appends follow the last good record.
+static int journal_replay_file(const char* path, int* metric_map, int repair) {
+    int fd = open(path, (repair ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0) return 0;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    uint8_t* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return 0;
+    }
+
+    size_t off = 0, size = (size_t)st.st_size;
+    int applied = 0;
+    while (size - off >= sizeof(JournalHeader)) {
+        JournalHeader h;
+        memcpy(&h, base + off, sizeof(h));
+        if (h.size > size - off - sizeof(h) ||
+            h.crc != sweetexp_crc32(sweetexp_crc32(0, &h.type, sizeof(h) - sizeof(h.crc)), base + off + sizeof(h), h.size)) {
+            break;
+        }
+        journal_apply(h.type, base + off + sizeof(h), h.size, metric_map);
+        off += sizeof(h) + h.size;
+        applied++;
+    }
+    munmap(base, size);
+    if (off < size) {
+        fprintf(stderr, "SweetEngine: %s: dropping %zu bytes of torn journal tail\n", path, size - off);
+        if (repair) ftruncate(fd, (off_t)off);
+    }
+    close(fd);
+    return applied;
+}
+
+// Replay the journal over the loaded snapshot and reopen it for appending
+int journal_open(void) {
+    int metric_map[MAX_METRICS];
+    for (int m = 0; m < MAX_METRICS; m++) metric_map[m] = -1;
+
+    pthread_mutex_lock(&journal.lock);
+    if (journal.fd >= 0) close(journal.fd);
+    journal.fd = -1;
+    journal.used = 0;
+    pthread_mutex_unlock(&journal.lock);
+
+    int replayed = journal_replay_file(SWEETEXP_JOURNAL_PATH ".prev", metric_map, 0);
+    replayed += journal_replay_file(SWEETEXP_JOURNAL_PATH, metric_map, 1);
+
+    int fd = open(SWEETEXP_JOURNAL_PATH, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    struct stat st;
+    pthread_mutex_lock(&journal.lock);
+    journal.fd = fd;
+    journal.bytes = fd >= 0 && fstat(fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+    pthread_mutex_unlock(&journal.lock);
+    if (fd < 0) {
+        fprintf(stderr, "SweetEngine: Cannot open %s: %s\n", SWEETEXP_JOURNAL_PATH, strerror(errno));
+        return -1;
+    }
+    journal_define_all_metrics();  // This process's metric ids
+
+    if (replayed > 0) log_engine_eventf("Journal: replayed %d records after checkpoint", replayed);
+    return replayed;
+}
+
+// ==================== PERSISTENCE WRITER ====================
+// Journal syncs and checkpoints run on one background thread so that no mutator
+// waits for the disk. Mutators journal their records, post a request and carry on;
+// requests made while the writer is busy merge into its next pass, so a burst of
+// unlocks costs one fdatasync. Unlocks are announced by the writer after the sync
+// that made them durable, keeping "announced implies persisted". Checkpoints go
+// through save_engine_data(), which snapshots copy-on-write (see snapshot_users).
+// Before the writer starts (load, --backfill) and after it stops, requests run
+// inline on the caller.
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int running;
+    int requests;                   // PERSIST_* bits not served yet
+    int announce_count;
+    PendingUnlock announce[PERSIST_ANNOUNCE_QUEUE];  // Journaled, not yet synced
+} persist = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, {{0, 0, 0}}};
+
+static void persist_run(int what) {
+    if (what & PERSIST_SYNC) journal_sync();
+    if (what & PERSIST_CHECKPOINT) save_engine_data();
+}
+
+// Ask the writer to sync the journal and/or checkpoint; never blocks on I/O
+// while the writer runs
+static void request_persist(int what) {
+    pthread_mutex_lock(&persist.lock);
+    if (persist.running) {
+        persist.requests |= what;
+        pthread_cond_signal(&persist.wake);
+        pthread_mutex_unlock(&persist.lock);
+        return;
+    }
+    pthread_mutex_unlock(&persist.lock);
+    persist_run(what);
+}
+
+// Queue journaled unlocks for announcement after the next sync. Returns 0 when
+// the caller must sync and announce itself (no writer, or the queue is full).
+static int persist_queue_unlocks(const PendingUnlock* unlocks, int count) {
+    pthread_mutex_lock(&persist.lock);
+    if (!persist.running || persist.announce_count + count > PERSIST_ANNOUNCE_QUEUE) {
+        pthread_mutex_unlock(&persist.lock);
+        return 0;
+    }
+    memcpy(&persist.announce[persist.announce_count], unlocks, (size_t)count * sizeof(*unlocks));
+    persist.announce_count += count;
+    persist.requests |= PERSIST_SYNC;
+    pthread_cond_signal(&persist.wake);
+    pthread_mutex_unlock(&persist.lock);
+    return 1;
+}
+
+static void* persist_writer_thread(void* arg) {
+    static PendingUnlock announce[PERSIST_ANNOUNCE_QUEUE];
+
+    pthread_mutex_lock(&persist.lock);
+    for (;;) {
+        while (persist.running && !persist.requests) pthread_cond_wait(&persist.wake, &persist.lock);
+        if (!persist.requests) break;  // Stopped and drained
+        int what = persist.requests;
+        int count = persist.announce_count;
+        memcpy(announce, persist.announce, (size_t)count * sizeof(*announce));
+        persist.requests = 0;
+        persist.announce_count = 0;
+        pthread_mutex_unlock(&persist.lock);
+
+        // Sync and announce before a checkpoint so unlocks are not held behind it
+        persist_run(what & PERSIST_SYNC);
+        for (int k = 0; k < count; k++) {
+            announce_unlock(announce[k].user_id, &engine.achievements[announce[k].achievement]);
+        }
+        persist_run(what & PERSIST_CHECKPOINT);
+
+        pthread_mutex_lock(&persist.lock);
+    }
+    pthread_mutex_unlock(&persist.lock);
+    return NULL;
+}
+
+int start_persist_writer(void) {
+    pthread_mutex_lock(&persist.lock);
+    persist.running = 1;
+    pthread_mutex_unlock(&persist.lock);
+    if (pthread_create(&engine.persist_thread, NULL, persist_writer_thread, NULL) != 0) {
+        pthread_mutex_lock(&persist.lock);
+        persist.running = 0;
+        pthread_mutex_unlock(&persist.lock);
+        fprintf(stderr, "SweetEngine: Cannot start persistence writer, syncing inline\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Serve what is still queued, then stop; later requests run inline
+void stop_persist_writer(void) {
+    pthread_mutex_lock(&persist.lock);
+    int was_running = persist.running;
+    persist.running = 0;
+    pthread_cond_signal(&persist.wake);
+    pthread_mutex_unlock(&persist.lock);
+    if (was_running) pthread_join(engine.persist_thread, NULL);
+}
+
+// ==================== SQLITE SINK ====================
+// Optional mirror of achievement progress into the NotifEngine database
+// (SQLITE_SINK=1, or a database path, in sweetexpengine.ini) so the UI's views
+// over user_achievements stay current. The notifications table is left to
+// NotifEngine.java, which inserts each notification it actually receives. Hot
+// paths only record a row in memory under a leaf lock; rows coalesce per
+// (user, achievement), last value wins. The sink thread owns one WAL-mode
+// connection with prepared statements and writes everything pending in a single
+// transaction once SQLITE_SINK_BATCH rows are queued or SQLITE_SINK_FLUSH_MS after
+// the first. At start, after the queue overflowed and after a failed write it
+// rescans every user's progress from the shards instead, so the rows always
+// converge. Built only with -DSWEETEXP_SQLITE_SINK (and -lsqlite3); otherwise
+// SQLITE_SINK is ignored with a warning.
+
+#ifdef SWEETEXP_SQLITE_SINK
+
+typedef struct {
+    int user_id;
+    int achievement;
+    int progress;
+    int unlocked;
+    int64_t unlock_time;
+} SinkProgressRow;
+
+typedef struct {
+    SinkProgressRow progress[SQLITE_SINK_MAX_ROWS];
+    int progress_count;
+} SinkBatch;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int running;
+    int resync;                     // Progress rows were lost: rescan the shards
+    uint64_t first_ms;              // When the oldest pending row was queued
+    uint16_t slot[2 * SQLITE_SINK_MAX_ROWS];  // (user, achievement) hash -> pending row + 1
+} sink = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, {0}};
+
+static SinkBatch sink_pending;      // Rows queued since the last flush, under sink.lock
+
+// Connection and statements, used by one thread at a time
+static struct {
+    sqlite3* db;
+    sqlite3_stmt* begin;
+    sqlite3_stmt* commit;
+    sqlite3_stmt* rollback;
+    sqlite3_stmt* upsert;
+    int rows_metric;
+    int flush_metric;
+} sink_conn;
+
+static uint64_t monotonic_ms(void);
+
+// Record a progress change for the sink (caller holds the user's shard lock)
+static void sqlite_sink_progress_locked(int user_id, int idx, const AchievementProgress* p) {
+    if (!__atomic_load_n(&sink.running, __ATOMIC_RELAXED)) return;
+
+    pthread_mutex_lock(&sink.lock);
+    if (!sink.resync) {
+        uint32_t mask = 2 * SQLITE_SINK_MAX_ROWS - 1;
+        uint32_t h = ((uint32_t)user_id * 0x9E3779B1u ^ (uint32_t)idx * 0x85EBCA77u) & mask;
+        while (sink.slot[h]) {
+            SinkProgressRow* row = &sink_pending.progress[sink.slot[h] - 1];
+            if (row->user_id == user_id && row->achievement == idx) break;
+            h = (h + 1) & mask;
+        }
+        SinkProgressRow* row;
+        if (sink.slot[h]) {
+            row = &sink_pending.progress[sink.slot[h] - 1];
+        } else if (sink_pending.progress_count < SQLITE_SINK_MAX_ROWS) {
+            row = &sink_pending.progress[sink_pending.progress_count++];
+            sink.slot[h] = (uint16_t)sink_pending.progress_count;
+        } else {
+            row = NULL;
+            sink.resync = 1;  // The rescan covers this and every later change
+            pthread_cond_signal(&sink.wake);
+        }
+        if (row) *row = (SinkProgressRow){user_id, idx, p->progress, p->unlocked, (int64_t)p->unlock_time};
+    }
+    if (!sink.first_ms) sink.first_ms = monotonic_ms();
+    if (sink_pending.progress_count == SQLITE_SINK_BATCH) pthread_cond_signal(&sink.wake);
+    pthread_mutex_unlock(&sink.lock);
+}
+
+static int sink_step(sqlite3_stmt* stmt) {
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    return rc;
+}
+
+// Write a batch in one transaction; rows violating a constraint are skipped.
+// Returns the rows written, -1 if the transaction failed.
+static int sqlite_sink_write(const SinkBatch* b) {
+    if (b->progress_count == 0) return 0;
+    if (sink_step(sink_conn.begin) != SQLITE_DONE) goto fail;
+
+    int written = 0;
+    for (int i = 0; i < b->progress_count; i++) {
+        const SinkProgressRow* r = &b->progress[i];
+        const Achievement* ach = &engine.achievements[r->achievement];
+        sqlite3_stmt* st = sink_conn.upsert;
+        sqlite3_bind_int(st, 1, r->user_id);
+        sqlite3_bind_text(st, 2, ach->id, -1, SQLITE_STATIC);  // Definition strings are never freed
+        sqlite3_bind_text(st, 3, ach->name, -1, SQLITE_STATIC);
+        sqlite3_bind_text(st, 4, ach->description, -1, SQLITE_STATIC);
+        sqlite3_bind_int(st, 5, r->progress);
+        sqlite3_bind_int(st, 6, ach->target);
+        sqlite3_bind_int(st, 7, r->unlocked);
+        sqlite3_bind_int64(st, 8, r->unlocked ? r->unlock_time : 0);
+        int rc = sink_step(st);
+        if (rc == SQLITE_DONE) written++;
+        else if (rc != SQLITE_CONSTRAINT) goto fail;
+    }
+    if (sink_step(sink_conn.commit) != SQLITE_DONE) goto fail;
+    return written;
+
+fail:
+    fprintf(stderr, "SweetEngine: SQLite sink write failed: %s\n", sqlite3_errmsg(sink_conn.db));
+    if (!sqlite3_get_autocommit(sink_conn.db)) sink_step(sink_conn.rollback);
+    return -1;
+}
+
+// Rewrite every user's progress from the shards, one user's rows at a time
+static int sqlite_sink_rescan(SinkBatch* b) {
+    b->progress_count = 0;
+    for (int s = 0; s < ACHIEVEMENT_SHARDS; s++) {
+        AchievementShard* shard = &engine.shards[s];
+        for (int slot = 0; slot < MAX_USERS_PER_SHARD; slot++) {
+            if (b->progress_count + MAX_ACHIEVEMENTS > SQLITE_SINK_MAX_ROWS) {
+                if (sqlite_sink_write(b) < 0) return -1;
+                b->progress_count = 0;
+            }
+            pthread_mutex_lock(&shard->lock);
+            const UserAchievementState* user = shard->users[slot];
+            for (int i = 0; user && i < engine.achievement_count; i++) {
+                const AchievementProgress* p = &user->progress[i];
+                if (p->progress == 0 && !p->unlocked) continue;
+                b->progress[b->progress_count++] =
+                    (SinkProgressRow){user->user_id, i, p->progress, p->unlocked, (int64_t)p->unlock_time};
+            }
+            pthread_mutex_unlock(&shard->lock);
+        }
+    }
+    return sqlite_sink_write(b) < 0 ? -1 : 0;
+}
+
+static int sqlite_sink_due_locked(void) {
+    int rows = sink_pending.progress_count;
+    return rows >= SQLITE_SINK_BATCH || (rows > 0 && monotonic_ms() >= sink.first_ms + SQLITE_SINK_FLUSH_MS);
+}
+
+static void* sqlite_sink_thread(void* arg) {
+    static SinkBatch batch;
+    int rescan = 1;  // Bring the tables up to date with the loaded state first
+
+    pthread_mutex_lock(&sink.lock);
+    for (;;) {
+        while (sink.running && !rescan && !sink.resync && !sqlite_sink_due_locked()) {
+            if (sink_pending.progress_count == 0) {
+                pthread_cond_wait(&sink.wake, &sink.lock);
+                continue;
+            }
+            uint64_t now = monotonic_ms();
+            uint64_t wait_ms = sink.first_ms + SQLITE_SINK_FLUSH_MS > now ? sink.first_ms + SQLITE_SINK_FLUSH_MS - now : 0;
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_sec += (time_t)(wait_ms / 1000);
+            until.tv_nsec += (long)(wait_ms % 1000) * 1000000L;
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&sink.wake, &sink.lock, &until);
+        }
+        int stopping = !sink.running;
+        rescan |= sink.resync;
+        sink.resync = 0;
+        batch.progress_count = rescan ? 0 : sink_pending.progress_count;  // A rescan supersedes them
+        memcpy(batch.progress, sink_pending.progress, (size_t)batch.progress_count * sizeof(SinkProgressRow));
+        sink_pending.progress_count = 0;
+        memset(sink.slot, 0, sizeof(sink.slot));
+        sink.first_ms = 0;
+        pthread_mutex_unlock(&sink.lock);
+
+        uint64_t t0 = monotonic_ms();
+        int written = sqlite_sink_write(&batch);
+        if (written >= 0 && rescan) written = sqlite_sink_rescan(&batch);
+        if (written > 0) record_metric_sample(sink_conn.rows_metric, written);
+        record_metric_sample(sink_conn.flush_metric, (int64_t)(monotonic_ms() - t0));
+        rescan = written < 0;  // Retry through a full rescan
+        if (stopping) break;
+        if (rescan) {
+            struct timespec backoff = {SQLITE_SINK_BUSY_MS / 1000, (SQLITE_SINK_BUSY_MS % 1000) * 1000000L};
+            nanosleep(&backoff, NULL);
+        }
+        pthread_mutex_lock(&sink.lock);
+    }
+    return NULL;
+}
+
+static void sqlite_sink_close(void) {
+    sqlite3_finalize(sink_conn.begin);
+    sqlite3_finalize(sink_conn.commit);
+    sqlite3_finalize(sink_conn.rollback);
+    sqlite3_finalize(sink_conn.upsert);
+    sqlite3_close(sink_conn.db);
+    memset(&sink_conn, 0, sizeof(sink_conn));
+}
+
+// Open the database named by SQLITE_SINK and start the sink thread; 0 if disabled
+int start_sqlite_sink(void) {
+    const char* path = engine.sqlite_sink_path;
+    if (!path[0]) return 0;
+
+    int rc = sqlite3_open_v2(path, &sink_conn.db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL);
+    if (rc == SQLITE_OK) {
+        sqlite3_busy_timeout(sink_conn.db, SQLITE_SINK_BUSY_MS);
+        rc = sqlite3_exec(sink_conn.db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", NULL, NULL, NULL);
+    }
+    if (rc == SQLITE_OK) rc = sqlite3_exec(sink_conn.db, SWEETEXP_SQL_SCHEMA, NULL, NULL, NULL);
+    const struct {
+        const char* sql;
+        sqlite3_stmt** stmt;
+    } statements[] = {
+        {"BEGIN IMMEDIATE", &sink_conn.begin},
+        {"COMMIT", &sink_conn.commit},
+        {"ROLLBACK", &sink_conn.rollback},
+        {SWEETEXP_SQL_UPSERT_ACHIEVEMENT, &sink_conn.upsert},
+    };
+    for (size_t i = 0; rc == SQLITE_OK && i < sizeof(statements) / sizeof(statements[0]); i++) {
+        rc = sqlite3_prepare_v3(sink_conn.db, statements[i].sql, -1, SQLITE_PREPARE_PERSISTENT, statements[i].stmt, NULL);
+    }
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SweetEngine: SQLite sink disabled, %s: %s\n", path,
+                sink_conn.db ? sqlite3_errmsg(sink_conn.db) : sqlite3_errstr(rc));
+        sqlite_sink_close();
+        return -1;
+    }
+    sink_conn.rows_metric = register_metric("sqlite_sink_rows");
+    sink_conn.flush_metric = register_metric("sqlite_flush_ms");
+
+    pthread_mutex_lock(&sink.lock);
+    sink.running = 1;
+    pthread_mutex_unlock(&sink.lock);
+    if (pthread_create(&engine.sqlite_thread, NULL, sqlite_sink_thread, NULL) != 0) {
+        pthread_mutex_lock(&sink.lock);
+        sink.running = 0;
+        pthread_mutex_unlock(&sink.lock);
+        sqlite_sink_close();
+        return -1;
+    }
+    return 0;
+}
+
+// Write what is pending, then close the database
+void stop_sqlite_sink(void) {
+    pthread_mutex_lock(&sink.lock);
+    int was_running = sink.running;
+    sink.running = 0;
+    pthread_cond_signal(&sink.wake);
+    pthread_mutex_unlock(&sink.lock);
+    if (!was_running) return;
+    pthread_join(engine.sqlite_thread, NULL);
+    sqlite_sink_close();
+}
+
+#else
+
+static void sqlite_sink_progress_locked(int user_id, int idx, const AchievementProgress* p) {
+    (void)user_id;
+    (void)idx;
+    (void)p;
+}
+
+int start_sqlite_sink(void) {
+    if (engine.sqlite_sink_path[0]) {
+        fprintf(stderr, "SweetEngine: SQLITE_SINK ignored, built without SWEETEXP_SQLITE_SINK\n");
+    }
+    return 0;
+}
+
+void stop_sqlite_sink(void) {}
+
+#endif // SWEETEXP_SQLITE_SINK
+
+// ==================== NOTIFICATION ROUTING FILTERS ====================
+// Applies users.notification_prefs before a notification is encoded or sent.
+// SWEETEXP_NOTIF_PREFS_PATH holds one `user_id|{prefs json}` line per user, as
+// exported from notif_engine.db, e.g.
+//   7|{"achievements":true,"random":false,"priority_filter":3,"quiet_hours":"22:00-07:30"}
+// Each user's JSON is compiled once into a NotifFilter: a bitmask of allowed types,
+// the minimum priority, and quiet intervals as minute-of-day ranges split at
+// midnight. A check is then a table probe and a few compares. The file is re-read
+// only when its mtime/size change, and a line is recompiled only when its text
+// hash differs from the one its filter was built from. Users without a line, and
+// types the prefs do not name, are allowed.
+
+enum {
+    NOTIF_TYPE_ACHIEVEMENT = 0,
+    NOTIF_TYPE_RANDOM,
+    NOTIF_TYPE_SYSTEM,
+    NOTIF_TYPE_KERNEL,
+    NOTIF_TYPE_WAYLAND,
+    NOTIF_TYPE_COUNT
+};
+
+// Prefs keys (plural "achievements" as in the users table default) and payload types
+static const char* const notif_type_keys[NOTIF_TYPE_COUNT] = {
+    "\"achievements\"", "\"random\"", "\"system\"", "\"kernel\"", "\"wayland\""
+};
+static const char* const notif_type_names[NOTIF_TYPE_COUNT] = {
+    "achievement", "random", "system", "kernel", "wayland"
+};
+
+typedef struct {
+    uint32_t type_mask;             // Bit per NOTIF_TYPE_*, set = allowed
+    int min_priority;               // priority_filter: lower priorities are dropped
+    int quiet_count;
+    uint16_t quiet_start[NOTIF_MAX_QUIET];  // Minute of day, local time
+    uint16_t quiet_len[NOTIF_MAX_QUIET];
+} NotifFilter;
+
+typedef struct {
+    int used;
+    int user_id;
+    uint32_t prefs_hash;            // FNV-1a of the JSON the filter was compiled from
+    NotifFilter filter;
+} NotifFilterSlot;
+
+static NotifFilterSlot notif_filters[MAX_NOTIF_FILTERS];
+static pthread_mutex_t notif_filter_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct stat notif_prefs_stat;
+
+static uint32_t notif_prefs_hash(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) h = (h ^ (uint8_t)s[i]) * 16777619u;
+    return h;
+}
+
+static NotifFilterSlot* notif_filter_slot(NotifFilterSlot* table, int user_id, int create) {
+    uint32_t h = user_hash(user_id) & (MAX_NOTIF_FILTERS - 1);
+    for (int probe = 0; probe < MAX_NOTIF_FILTERS; probe++) {
+        NotifFilterSlot* slot = &table[(h + probe) & (MAX_NOTIF_FILTERS - 1)];
+        if (slot->used && slot->user_id == user_id) return slot;
+        if (!slot->used) {
+            if (!create) return NULL;
+            slot->used = 1;
+            slot->user_id = user_id;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+// Value following "key": in a flat JSON object, or NULL
+static const char* prefs_value(const char* json, const char* key) {
+    const char* p = strstr(json, key);
+    if (!p) return NULL;
+    p += strlen(key);
+    p += strspn(p, " \t");
+    if (*p != ':') return NULL;
+    return p + 1 + strspn(p + 1, " \t");
+}
+
+static void notif_filter_add_quiet(NotifFilter* f, int start, int end) {
+    if (f->quiet_count == NOTIF_MAX_QUIET || start == end) return;
+    f->quiet_start[f->quiet_count] = (uint16_t)start;
+    f->quiet_len[f->quiet_count] = (uint16_t)(end - start);
+    f->quiet_count++;
+}
+
+static void notif_filter_compile(const char* json, NotifFilter* f) {
+    memset(f, 0, sizeof(*f));
+    f->type_mask = ~0u;
+    f->min_priority = 1;
+
+    for (int t = 0; t < NOTIF_TYPE_COUNT; t++) {
+        const char* v = prefs_value(json, notif_type_keys[t]);
+        if (v && strncmp(v, "false", 5) == 0) f->type_mask &= ~(1u << t);
+    }
+    const char* v = prefs_value(json, "\"priority_filter\"");
+    if (v) f->min_priority = atoi(v);
+
+    // "HH:MM-HH:MM[,HH:MM-HH:MM...]"; an interval past midnight becomes two
+    v = prefs_value(json, "\"quiet_hours\"");
+    if (!v || *v != '"') return;
+    for (v++; *v && *v != '"'; ) {
+        int h1, m1, h2, m2, used = 0;
+        if (sscanf(v, "%d:%d-%d:%d%n", &h1, &m1, &h2, &m2, &used) != 4) break;
+        int start = (h1 * 60 + m1) % 1440, end = (h2 * 60 + m2) % 1440;
+        if (start < end) {
+            notif_filter_add_quiet(f, start, end);
+        } else {
+            notif_filter_add_quiet(f, start, 1440);
+            notif_filter_add_quiet(f, 0, end);
+        }
+        v += used;
+        v += strspn(v, ", ");
+    }
+}
+
+// Re-read the prefs file if it changed; returns the number of filters recompiled
+int refresh_notification_filters(void) {
+    struct stat st;
+    if (stat(SWEETEXP_NOTIF_PREFS_PATH, &st) < 0) memset(&st, 0, sizeof(st));
+    if (st.st_ino == notif_prefs_stat.st_ino && st.st_size == notif_prefs_stat.st_size &&
+        st.st_mtim.tv_sec == notif_prefs_stat.st_mtim.tv_sec &&
+        st.st_mtim.tv_nsec == notif_prefs_stat.st_mtim.tv_nsec) {
+        return 0;
+    }
+    notif_prefs_stat = st;
+
+    // Build the new table beside the live one, reusing unchanged filters
+    NotifFilterSlot* next = calloc(MAX_NOTIF_FILTERS, sizeof(NotifFilterSlot));
+    if (!next) return -1;
+    int compiled = 0, kept = 0;
+    FILE* fp = fopen(SWEETEXP_NOTIF_PREFS_PATH, "r");
+    char line[1024];
+    while (fp && fgets(line, sizeof(line), fp)) {
+        char* bar = strchr(line, '|');
+        if (!bar || line[0] == '#') continue;
+        int user_id = atoi(line);
+        char* json = bar + 1;
+        json[strcspn(json, "\r\n")] = '\0';
+        uint32_t hash = notif_prefs_hash(json, strlen(json));
+
+        NotifFilterSlot* slot = notif_filter_slot(next, user_id, 1);
+        if (!slot) break;
+        pthread_mutex_lock(&notif_filter_lock);
+        NotifFilterSlot* old = notif_filter_slot(notif_filters, user_id, 0);
+        int reuse = old && old->prefs_hash == hash;
+        if (reuse) slot->filter = old->filter;
+        pthread_mutex_unlock(&notif_filter_lock);
+        if (!reuse) {
+            notif_filter_compile(json, &slot->filter);
+            compiled++;
+        } else {
+            kept++;
+        }
+        slot->prefs_hash = hash;
+    }
+    if (fp) fclose(fp);
+
+    pthread_mutex_lock(&notif_filter_lock);
+    memcpy(notif_filters, next, sizeof(notif_filters));
+    pthread_mutex_unlock(&notif_filter_lock);
+    free(next);
+
+    log_engine_eventf("Notification prefs reloaded: %d compiled, %d unchanged", compiled, kept);
+    return compiled;
+}
+
+// 1 if `user_id` wants a notification of this type and priority right now
+int notification_allowed(int user_id, const char* type, int priority) {
+    int t = 0;
+    while (t < NOTIF_TYPE_COUNT && strcmp(type, notif_type_names[t]) != 0) t++;
+
+    pthread_mutex_lock(&notif_filter_lock);
+    const NotifFilterSlot* slot = notif_filter_slot(notif_filters, user_id, 0);
+    NotifFilter f;
+    if (slot) f = slot->filter;
+    pthread_mutex_unlock(&notif_filter_lock);
+    if (!slot) return 1;
+
+    if (t < NOTIF_TYPE_COUNT && !(f.type_mask & (1u << t))) return 0;
+    if (priority < f.min_priority) return 0;
+    if (f.quiet_count == 0 || priority >= NOTIF_QUIET_BREAKTHROUGH) return 1;
+
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    unsigned int minute = (unsigned int)(local.tm_hour * 60 + local.tm_min);
+    for (int q = 0; q < f.quiet_count; q++) {
+        if (minute - f.quiet_start[q] < f.quiet_len[q]) return 0;
+    }
+    return 1;
+}
+
+// ==================== NOTIFICATION DIGESTS ====================
+// Low-priority traffic (priority <= DIGEST_MAX_PRIORITY) of a type configured with
+// DIGEST=<type>,<interval_sec>,<max_count> in sweetexpengine.ini is not sent one by
+// one. It is counted into a per-(user, type) digest and sent as one summary when the
+// interval since the first pending message elapses or max_count messages are pending,
+// whichever comes first; each summary is one connection and one NotifEngine insert
+// instead of dozens. A digest keeps counts and up to DIGEST_SAMPLES distinct messages,
+// so its size does not grow with traffic. Achievement notifications are never
+// digested. A due summary is held back while the user's quiet hours block it.
+
+typedef struct {
+    int used;
+    int user_id;
+    int type;                       // NOTIF_TYPE_*
+    int count;
+    int max_priority;
+    time_t first;
+    int sample_count;
+    int sample_hits[DIGEST_SAMPLES];
+    char samples[DIGEST_SAMPLES][DIGEST_SAMPLE_LEN];
+} NotifDigest;
+
+static int digest_interval_sec[NOTIF_TYPE_COUNT];  // 0 = digest mode off for the type
+static int digest_max_count[NOTIF_TYPE_COUNT];
+static NotifDigest notif_digests[MAX_NOTIF_DIGESTS];
+static pthread_mutex_t notif_digest_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Parse a DIGEST= value: "<type>,<interval_sec>[,<max_count>]"; interval 0 disables
+int configure_notification_digest(const char* spec) {
+    char name[32];
+    int interval = 0, max_count = 0;
+    if (sscanf(spec, "%31[^,],%d,%d", name, &interval, &max_count) < 2) return -1;
+    for (int t = 0; t < NOTIF_TYPE_COUNT; t++) {
+        if (t == NOTIF_TYPE_ACHIEVEMENT || strcmp(name, notif_type_names[t]) != 0) continue;
+        pthread_mutex_lock(&notif_digest_lock);
+        digest_interval_sec[t] = interval > 0 ? interval : 0;
+        digest_max_count[t] = max_count > 0 ? max_count : INT_MAX;
+        pthread_mutex_unlock(&notif_digest_lock);
+        return 0;
+    }
+    fprintf(stderr, "SweetEngine: DIGEST type '%s' cannot be digested\n", name);
+    return -1;
+}
+
+// Build the summary text for a digest and reset it (digest lock held)
+static void digest_take_locked(NotifDigest* d, char* out, size_t out_size) {
+    struct tm local;
+    localtime_r(&d->first, &local);
+    int len = snprintf(out, out_size, "%d %s notifications since %02d:%02d: ",
+                       d->count, notif_type_names[d->type], local.tm_hour, local.tm_min);
+    int quoted = 0;
+    for (int i = 0; i < d->sample_count && len > 0 && (size_t)len < out_size; i++) {
+        len += snprintf(out + len, out_size - (size_t)len, "%s%s (x%d)", i ? ", " : "", d->samples[i], d->sample_hits[i]);
+        quoted += d->sample_hits[i];
+    }
+    if (quoted < d->count && len > 0 && (size_t)len < out_size) {
+        snprintf(out + len, out_size - (size_t)len, " and %d more", d->count - quoted);
+    }
+    d->used = 0;
+}
+
+// Buffer a notification for its digest; returns 1 if taken, 0 to send it now
+int notification_digest_add(int user_id, const char* message, const char* type, int priority) {
+    if (priority > DIGEST_MAX_PRIORITY) return 0;
+    int t = 0;
+    while (t < NOTIF_TYPE_COUNT && strcmp(type, notif_type_names[t]) != 0) t++;
+    if (t == NOTIF_TYPE_COUNT || t == NOTIF_TYPE_ACHIEVEMENT) return 0;
+
+    char summary[256];
+    int full = 0, max_priority = priority;
+    pthread_mutex_lock(&notif_digest_lock);
+    if (digest_interval_sec[t] == 0) {
+        pthread_mutex_unlock(&notif_digest_lock);
+        return 0;
+    }
+    NotifDigest* d = NULL;
+    NotifDigest* free_slot = NULL;
+    for (int i = 0; i < MAX_NOTIF_DIGESTS && !d; i++) {
+        NotifDigest* c = &notif_digests[i];
+        if (c->used && c->user_id == user_id && c->type == t) d = c;
+        else if (!c->used && !free_slot) free_slot = c;
+    }
+    if (!d && !free_slot) {
+        pthread_mutex_unlock(&notif_digest_lock);
+        return 0;  // Table full: send individually
+    }
+    if (!d) {
+        d = free_slot;
+        memset(d, 0, sizeof(*d));
+        d->used = 1;
+        d->user_id = user_id;
+        d->type = t;
+        d->first = time(NULL);
+    }
+    d->count++;
+    if (priority > d->max_priority) d->max_priority = priority;
+    int s = 0;
+    while (s < d->sample_count && strncmp(d->samples[s], message, DIGEST_SAMPLE_LEN - 1) != 0) s++;
+    if (s < d->sample_count) {
+        d->sample_hits[s]++;
+    } else if (s < DIGEST_SAMPLES) {
+        strncpy(d->samples[s], message, DIGEST_SAMPLE_LEN - 1);
+        d->samples[s][strcspn(d->samples[s], "\n")] = '\0';
+        d->sample_hits[s] = 1;
+        d->sample_count++;
+    }
+    if (d->count >= digest_max_count[t]) {
+        max_priority = d->max_priority;
+        digest_take_locked(d, summary, sizeof(summary));
+        full = 1;
+    }
+    pthread_mutex_unlock(&notif_digest_lock);
+
+    if (full) deliver_notification(user_id, summary, notif_type_names[t], max_priority);
+    return 1;
+}
+
+// Send every digest whose interval elapsed (or all of them when `force`)
+void flush_notification_digests(int force) {
+    typedef struct {
+        int user_id;
+        int type;
+        int priority;
+        char message[256];
+    } DueDigest;
+    DueDigest due[MAX_NOTIF_DIGESTS];
+    int due_count = 0;
+    time_t now = time(NULL);
+
+    pthread_mutex_lock(&notif_digest_lock);
+    for (int i = 0; i < MAX_NOTIF_DIGESTS; i++) {
+        NotifDigest* d = &notif_digests[i];
+        if (!d->used) continue;
+        if (!force) {
+            if (now - d->first < digest_interval_sec[d->type]) continue;
+            if (!notification_allowed(d->user_id, notif_type_names[d->type], d->max_priority)) continue;
+        }
+        DueDigest* out = &due[due_count++];
+        out->user_id = d->user_id;
+        out->type = d->type;
+        out->priority = d->max_priority;
+        digest_take_locked(d, out->message, sizeof(out->message));
+    }
+    pthread_mutex_unlock(&notif_digest_lock);
+
+    for (int i = 0; i < due_count; i++) {
+        deliver_notification(due[i].user_id, due[i].message, notif_type_names[due[i].type], due[i].priority);
+    }
+}
+
+// ==================== SCHEDULED NOTIFICATIONS ====================
+// Hierarchical timing wheel: four levels of 64 slots cover ~194 days at one-second
+// resolution, anything further out is parked in the top level and re-cascaded until
+// due. Insert and cancel are O(1) list operations, every timer due in a tick fires as
+// one batch, and the single timerfd is only armed for the next tick that has work
+// (a due level-0 slot or the cascade of an occupied higher slot).
+// Pending timers are persisted as an append-only record log that is compacted on load.
+
+static inline uint64_t wheel_rotr(uint64_t v, unsigned int n) {
+    n &= 63;
+    return n ? (v >> n) | (v << (64 - n)) : v;
+}
+
+static inline int64_t timer_make_id(const ScheduledTimer* t) {
+    return ((int64_t)t->generation << TIMER_ID_INDEX_BITS) | (int64_t)(t - timer_wheel.pool);
+}
+
+// Link a timer into the slot matching its distance from the wheel position
+static void wheel_link_locked(ScheduledTimer* t) {
+    uint64_t expires = t->expires < timer_wheel.now ? timer_wheel.now : t->expires;
+    uint64_t delta = expires - timer_wheel.now;
+    uint64_t horizon = (uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS);
+    int level = 0;
+
+    if (delta >= horizon) {
+        expires = timer_wheel.now + horizon - 1;  // Parked, re-cascaded until due
+        delta = horizon - 1;
+    }
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= ((uint64_t)1 << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    int slot = (int)((expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    ScheduledTimer** head = &timer_wheel.slots[level][slot];
+    t->level = (uint8_t)level;
+    t->slot = (uint8_t)slot;
+    t->next = *head;
+    if (t->next) t->next->pprev = &t->next;
+    t->pprev = head;
+    *head = t;
+    timer_wheel.occupied[level] |= (uint64_t)1 << slot;
+}
+
+static void wheel_unlink_locked(ScheduledTimer* t) {
+    *t->pprev = t->next;
+    if (t->next) t->next->pprev = t->pprev;
+    if (!timer_wheel.slots[t->level][t->slot]) {
+        timer_wheel.occupied[t->level] &= ~((uint64_t)1 << t->slot);
+    }
+    t->next = NULL;
+    t->pprev = NULL;
+}
+
+// Redistribute the current slot of a higher level into the levels below
+static void wheel_cascade_locked(int level) {
+    int slot = (int)((timer_wheel.now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    ScheduledTimer* t = timer_wheel.slots[level][slot];
+
+    timer_wheel.slots[level][slot] = NULL;
+    timer_wheel.occupied[level] &= ~((uint64_t)1 << slot);
+    while (t) {
+        ScheduledTimer* next = t->next;
+        wheel_link_locked(t);
+        t = next;
+    }
+}
+
+// Earliest tick at which the wheel has work, UINT64_MAX if empty
+static uint64_t wheel_next_tick_locked(void) {
+    uint64_t now = timer_wheel.now;
+    uint64_t best = UINT64_MAX;
+
+    if (timer_wheel.occupied[0]) {
+        uint64_t r = wheel_rotr(timer_wheel.occupied[0], (unsigned int)(now & TIMER_WHEEL_MASK));
+        best = now + (uint64_t)__builtin_ctzll(r);
+    }
+
+    for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        if (!timer_wheel.occupied[level]) continue;
+        unsigned int shift = TIMER_WHEEL_BITS * level;
+        uint64_t base = now >> shift;
+        // On an unprocessed boundary the current slot is still waiting for its cascade
+        int aligned = (now & (((uint64_t)1 << shift) - 1)) == 0;
+        unsigned int from = (unsigned int)((base + (aligned ? 0 : 1)) & TIMER_WHEEL_MASK);
+        uint64_t r = wheel_rotr(timer_wheel.occupied[level], from);
+        uint64_t tick = (base + (aligned ? 0 : 1) + (uint64_t)__builtin_ctzll(r)) << shift;
+        if (tick < best) best = tick;
+    }
+    return best;
+}
+
+// Advance through `target`, collecting due timers; stops early when the batch is full
+static int wheel_advance_locked(uint64_t target, ScheduledTimer** batch, int max) {
+    int n = 0;
+
+    while (timer_wheel.now <= target) {
+        uint64_t now = timer_wheel.now;
+        for (int level = TIMER_WHEEL_LEVELS - 1; level >= 1; level--) {
+            if ((now & (((uint64_t)1 << (TIMER_WHEEL_BITS * level)) - 1)) == 0) {
+                wheel_cascade_locked(level);
+            }
         }
-        pthread_mutex_unlock(&engine.data_mutex);
-        
-        sleep(5);
+
+        int slot = (int)(now & TIMER_WHEEL_MASK);
+        while (timer_wheel.slots[0][slot] && n < max) {
+            ScheduledTimer* t = timer_wheel.slots[0][slot];
+            wheel_unlink_locked(t);
+            batch[n++] = t;
+        }
+        if (timer_wheel.slots[0][slot]) break;  // Batch full, resume this tick
+
+        // Skip straight to the next tick with work instead of walking empty ones
+        timer_wheel.now = now + 1;
+        uint64_t next = wheel_next_tick_locked();
+        if (next > target) {
+            timer_wheel.now = target + 1;
+            break;
+        }
+        timer_wheel.now = next;
     }
-    return NULL;
+    return n;
 }
 
-// Kernel hook listener (placeholder for /lumen-motonexus6/fw/boot/main/k integration)
-void* kernel_hook_listener(void* arg) {
-    int fd = inotify_init();
-    if (fd < 0) return NULL;
-    
-    // Watch kernel directories for activity
-    int wd = inotify_add_watch(fd, "/proc/stat", IN_MODIFY);
-    char buffer[INOTIFY_BUFFER_SIZE];
-    
-    while (engine.enabled) {
-        ssize_t len = read(fd, buffer, INOTIFY_BUFFER_SIZE);
-        if (len > 0) {
-            // Kernel activity detected - potential achievement trigger
-            pthread_mutex_lock(&engine.data_mutex);
-            check_achievement_progress();
-            pthread_mutex_unlock(&engine.data_mutex);
+// Arm the timerfd for the next tick with work (or disarm when idle)
+static void wheel_rearm_locked(void) {
+    uint64_t next = wheel_next_tick_locked();
+    struct itimerspec its;
+
+    if (next == UINT64_MAX) next = 0;
+    if (next == timer_wheel.armed) return;
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = (time_t)next;
+    timerfd_settime(timer_wheel.timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+    timer_wheel.armed = next;
+}
+
+static ScheduledTimer* timer_alloc_locked(void) {
+    ScheduledTimer* t = timer_wheel.free_list;
+    if (!t) return NULL;
+    timer_wheel.free_list = t->next;
+    t->next = NULL;
+    t->generation++;
+    t->active = 1;
+    timer_wheel.pending++;
+    return t;
+}
+
+static void timer_release_locked(ScheduledTimer* t) {
+    t->active = 0;
+    t->next = timer_wheel.free_list;
+    timer_wheel.free_list = t;
+    timer_wheel.pending--;
+}
+
+// Rewrite the persist file with only the pending timers
+static void timer_compact_locked(void) {
+    if (timer_wheel.persist_fd >= 0) close(timer_wheel.persist_fd);
+    timer_wheel.persist_fd = -1;
+    timer_wheel.log_records = 0;
+
+    // Rewrite the live set through a temp file so a crash keeps the old log
+    TimerRecord* recs = calloc(timer_wheel.pending > 0 ? (size_t)timer_wheel.pending : 1, sizeof(TimerRecord));
+    int count = 0;
+    for (int i = 0; recs && i < MAX_SCHEDULED_TIMERS && count < timer_wheel.pending; i++) {
+        ScheduledTimer* t = &timer_wheel.pool[i];
+        if (!t->active) continue;
+        TimerRecord* rec = &recs[count++];
+        rec->op = TIMER_REC_ADD;
+        rec->timer_id = timer_make_id(t);
+        rec->deliver_at = (int64_t)t->expires;
+        rec->notif = t->notif;
+    }
+    struct iovec iov = {recs, sizeof(TimerRecord) * (size_t)count};
+    if (recs && atomic_write_file(SWEETEXP_TIMERS_PATH, &iov, 1) >= 0) {
+        timer_wheel.log_records = count;
+    }
+    free(recs);
+    timer_wheel.persist_fd = open(SWEETEXP_TIMERS_PATH, O_WRONLY | O_APPEND | O_CREAT, 0644);
+}
+
+// Append records for a batch of timers in one write
+static void timer_persist_locked(uint32_t op, ScheduledTimer** timers, int count) {
+    TimerRecord recs[TIMER_FIRE_BATCH];
+
+    if (timer_wheel.persist_fd < 0) return;
+    for (int base = 0; base < count; base += TIMER_FIRE_BATCH) {
+        int n = count - base < TIMER_FIRE_BATCH ? count - base : TIMER_FIRE_BATCH;
+        memset(recs, 0, sizeof(TimerRecord) * n);
+        for (int i = 0; i < n; i++) {
+            ScheduledTimer* t = timers[base + i];
+            recs[i].op = op;
+            recs[i].timer_id = timer_make_id(t);
+            recs[i].deliver_at = (int64_t)t->expires;
+            if (op == TIMER_REC_ADD) recs[i].notif = t->notif;
+        }
+        if (write(timer_wheel.persist_fd, recs, sizeof(TimerRecord) * n) > 0) {
+            timer_wheel.log_records += n;
+        }
+    }
+
+    if (timer_wheel.log_records > 2 * timer_wheel.pending + MAX_SCHEDULED_TIMERS) {
+        timer_compact_locked();
+    }
+}
+
+// Replay the persisted record log into the wheel
+static void timer_load_persisted_locked(void) {
+    static ScheduledTimer* by_old_index[MAX_SCHEDULED_TIMERS];
+    static int64_t old_ids[MAX_SCHEDULED_TIMERS];
+    TimerRecord rec;
+
+    int fd = open(SWEETEXP_TIMERS_PATH, O_RDONLY);
+    if (fd < 0) return;
+
+    memset(by_old_index, 0, sizeof(by_old_index));
+    while (read(fd, &rec, sizeof(rec)) == (ssize_t)sizeof(rec)) {
+        if (rec.timer_id <= 0) continue;
+        int idx = (int)(rec.timer_id & ((1 << TIMER_ID_INDEX_BITS) - 1));
+        if (idx >= MAX_SCHEDULED_TIMERS) continue;
+
+        if (rec.op == TIMER_REC_ADD) {
+            ScheduledTimer* t = timer_alloc_locked();
+            if (!t) break;
+            t->expires = rec.deliver_at > 0 ? (uint64_t)rec.deliver_at : 0;
+            t->notif = rec.notif;
+            t->notif.message[sizeof(t->notif.message) - 1] = '\0';
+            t->notif.type[sizeof(t->notif.type) - 1] = '\0';
+            wheel_link_locked(t);
+            by_old_index[idx] = t;
+            old_ids[idx] = rec.timer_id;
+        } else if (rec.op == TIMER_REC_DEL && by_old_index[idx] && old_ids[idx] == rec.timer_id) {
+            wheel_unlink_locked(by_old_index[idx]);
+            timer_release_locked(by_old_index[idx]);
+            by_old_index[idx] = NULL;
         }
     }
-    
     close(fd);
-    return NULL;
 }
 
-// Save engine state
-int save_engine_data(void) {
-    pthread_mutex_lock(&engine.data_mutex);
-    
-    int fd = open(SWEETEXP_DATA_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (fd < 0) {
-        pthread_mutex_unlock(&engine.data_mutex);
+// Set up the wheel, its timerfd and any timers that survived a restart
+int init_timer_wheel(void) {
+    pthread_mutex_init(&timer_wheel.lock, NULL);
+    timer_wheel.persist_fd = -1;
+    timer_wheel.timer_fd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC);
+    if (timer_wheel.timer_fd < 0) {
+        fprintf(stderr, "SweetEngine: timerfd_create failed: %s\n", strerror(errno));
         return -1;
     }
-    
-    char buffer[DATA_BUFFER_SIZE];
-    int written = 0;
-    
-    // Write header
-    written += snprintf(buffer + written, sizeof(buffer) - written, 
-                       "SWEETENGINE_DATA_v1
-");
-    
-    // Write achievements
-    for (int i = 0; i < engine.achievement_count; i++) {
-        Achievement* ach = &engine.achievements[i];
-        written += snprintf(buffer + written, sizeof(buffer) - written,
-                           "ACH:%s|%s|%s|%d|%d|%d|%ld
-",
-                           ach->id, ach->name, ach->description,
-                           ach->progress, ach->target, ach->unlocked, ach->unlock_time);
+
+    pthread_mutex_lock(&timer_wheel.lock);
+    for (int i = MAX_SCHEDULED_TIMERS - 1; i >= 0; i--) {
+        timer_wheel.pool[i].next = timer_wheel.free_list;
+        timer_wheel.free_list = &timer_wheel.pool[i];
     }
-    
-    write(fd, buffer, written);
-    close(fd);
-    pthread_mutex_unlock(&engine.data_mutex);
+    timer_wheel.now = (uint64_t)time(NULL);
+    timer_load_persisted_locked();
+    timer_compact_locked();
+    wheel_rearm_locked();
+    int pending = timer_wheel.pending;
+    pthread_mutex_unlock(&timer_wheel.lock);
+
+    printf("SweetEngine: Timer wheel ready, %d scheduled notifications restored\n", pending);
     return 0;
 }
 
-// Load engine state
-int load_engine_data(void) {
-    int fd = open(SWEETEXP_DATA_PATH, O_RDONLY);
-    if (fd < 0) return -1;
-    
-    char buffer[DATA_BUFFER_SIZE];
-    ssize_t len = read(fd, buffer, sizeof(buffer) - 1);
-    close(fd);
-    
-    if (len <= 0) return -1;
-    buffer[len] = '';
-    
-    // Parse achievements
-    char* line = strtok(buffer, "
-");
-    engine.achievement_count = 0;
-    
-    while (line && engine.achievement_count < MAX_ACHIEVEMENTS) {
-        if (strncmp(line, "ACH:", 4) == 0) {
-            Achievement* ach = &engine.achievements[engine.achievement_count];
-            sscanf(line + 4, "%31[^|]|%63[^|]|%127[^|]|%d|%d|%d|%ld",
-                   ach->id, ach->name, ach->description,
-                   &ach->progress, &ach->target, &ach->unlocked, &ach->unlock_time);
-            engine.achievement_count++;
+// Schedule a notification for wall-clock time `deliver_at`; returns a timer id or -1
+int64_t schedule_notification_at(time_t deliver_at, const char* message, const char* type, int priority) {
+    pthread_mutex_lock(&timer_wheel.lock);
+    if (timer_wheel.pending == 0) {
+        timer_wheel.now = (uint64_t)time(NULL);  // Idle wheel: resync without walking ticks
+    }
+
+    ScheduledTimer* t = timer_alloc_locked();
+    if (!t) {
+        pthread_mutex_unlock(&timer_wheel.lock);
+        lumenlog_write(LUMENLOG_WARNING, ENGINE_LOG_TAG, "Timer wheel full, scheduled notification dropped");
+        return -1;
+    }
+
+    t->expires = deliver_at > 0 ? (uint64_t)deliver_at : 0;
+    memset(&t->notif, 0, sizeof(t->notif));
+    strncpy(t->notif.message, message, sizeof(t->notif.message) - 1);
+    strncpy(t->notif.type, type, sizeof(t->notif.type) - 1);
+    t->notif.priority = priority;
+    t->notif.timestamp = deliver_at;
+
+    int64_t id = timer_make_id(t);
+    wheel_link_locked(t);
+    timer_persist_locked(TIMER_REC_ADD, &t, 1);
+    wheel_rearm_locked();
+    pthread_mutex_unlock(&timer_wheel.lock);
+    return id;
+}
+
+// Schedule a notification `delay_sec` seconds from now
+int64_t schedule_notification_in(unsigned int delay_sec, const char* message, const char* type, int priority) {
+    return schedule_notification_at(time(NULL) + (time_t)delay_sec, message, type, priority);
+}
+
+// Cancel a pending scheduled notification; returns 0 on success, -1 if unknown or already fired
+int cancel_scheduled_notification(int64_t timer_id) {
+    if (timer_id <= 0) return -1;
+    int idx = (int)(timer_id & ((1 << TIMER_ID_INDEX_BITS) - 1));
+    uint32_t generation = (uint32_t)(timer_id >> TIMER_ID_INDEX_BITS);
+    if (idx >= MAX_SCHEDULED_TIMERS) return -1;
+
+    pthread_mutex_lock(&timer_wheel.lock);
+    ScheduledTimer* t = &timer_wheel.pool[idx];
+    if (!t->active || t->generation != generation) {
+        pthread_mutex_unlock(&timer_wheel.lock);
+        return -1;
+    }
+    wheel_unlink_locked(t);
+    timer_persist_locked(TIMER_REC_DEL, &t, 1);
+    timer_release_locked(t);
+    wheel_rearm_locked();
+    pthread_mutex_unlock(&timer_wheel.lock);
+    return 0;
+}
+
+// Hand a fired batch to the dispatcher queue in one critical section
+static void deliver_fired_batch(const Notification* batch, int count) {
+    int i = 0;
+
+    pthread_mutex_lock(&engine.data_mutex);
+    for (; i < count && engine.notification_count < MAX_NOTIFICATIONS - 1; i++) {
+        engine.notification_queue[engine.notification_tail] = batch[i];
+        engine.notification_tail = (engine.notification_tail + 1) % MAX_NOTIFICATIONS;
+        engine.notification_count++;
+    }
+    pthread_mutex_unlock(&engine.data_mutex);
+
+    // Queue full: deliver the remainder directly rather than drop them
+    for (; i < count; i++) {
+        send_notification(batch[i].message, batch[i].type, batch[i].priority);
+    }
+}
+
+// Timer wheel thread: one wake-up per due tick, fires everything due as a batch
+void* timer_wheel_thread(void* arg) {
+    ScheduledTimer* batch[TIMER_FIRE_BATCH];
+    Notification fired[TIMER_FIRE_BATCH];
+    uint64_t expirations;
+
+    while (engine.enabled) {
+        ssize_t len = read(timer_wheel.timer_fd, &expirations, sizeof(expirations));
+        if (len < 0 && errno != ECANCELED) {
+            if (errno != EINTR) sleep(1);
+            continue;
         }
-        line = strtok(NULL, "
-");
+
+        int n;
+        do {
+            pthread_mutex_lock(&timer_wheel.lock);
+            n = wheel_advance_locked((uint64_t)time(NULL), batch, TIMER_FIRE_BATCH);
+            timer_persist_locked(TIMER_REC_DEL, batch, n);
+            for (int i = 0; i < n; i++) {
+                fired[i] = batch[i]->notif;
+                timer_release_locked(batch[i]);
+            }
+            timer_wheel.armed = 0;  // Expired; force a fresh arm
+            wheel_rearm_locked();
+            pthread_mutex_unlock(&timer_wheel.lock);
+
+            if (n > 0) deliver_fired_batch(fired, n);
+        } while (n == TIMER_FIRE_BATCH);
     }
-    
-    // Initialize default achievements if empty
-    if (engine.achievement_count == 0) {
-        // Boot Master
-        strcpy(engine.achievements[0].id, "boot_master");
-        strcpy(engine.achievements[0].name, "Boot Master");
-        strcpy(engine.achievements[0].description, "Boot 10 times successfully");
-        engine.achievements[0].target = 10;
-        engine.achievement_count = 1;
-        
-        // Wayland Pro
-        strcpy(engine.achievements[1].id, "wayland_pro");
-        strcpy(engine.achievements[1].name, "Wayland Pro");
-        strcpy(engine.achievements[1].description, "Process 500 Wayland events");
-        engine.achievements[1].target = 500;
-        engine.achievement_count = 2;
+    return NULL;
+}
+
+// Expire the timerfd now: an idle wheel leaves it disarmed, and the thread only
+// sees engine.enabled drop once its read returns
+void wake_timer_wheel(void) {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_nsec = 1;
+    pthread_mutex_lock(&timer_wheel.lock);
+    timerfd_settime(timer_wheel.timer_fd, 0, &its, NULL);
+    pthread_mutex_unlock(&timer_wheel.lock);
+}
+
+// ==================== PROGRESS SUBSCRIPTIONS ====================
+// UI clients connect to SWEETEXP_SUBSCRIBE_SOCK, send a sweetexp_sub_request for one
+// user plus up to SWEETEXP_SUB_MAX_KEYS achievement/metric names, and receive
+// binary sweetexp_sub_delta frames (see sweetexp_abi.h). Nothing is queued on the
+// engine's update path: on each client's tick the server compares the user's
+// version counter, copies only the subscribed values and sends those that changed.
+// Deltas are therefore coalesced at the client's rate, a slow client never holds
+// more than one unsent frame (its backlog is just "latest value per key"), and the
+// cost per subscriber is bounded by its key count, not by the event rate.
+
+#define RANK_REPLY_MAX (sizeof(sweetexp_rank_reply) + SWEETEXP_RANK_MAX_ENTRIES * sizeof(sweetexp_rank_entry))
+
+typedef struct {
+    int fd;
+    int user_id;
+    int key_count;
+    uint8_t key_kind[SWEETEXP_SUB_MAX_KEYS];
+    int key_ref[SWEETEXP_SUB_MAX_KEYS];         // Achievement index or metric id, -1 unknown
+    int64_t last_value[SWEETEXP_SUB_MAX_KEYS];
+    uint8_t last_unlocked[SWEETEXP_SUB_MAX_KEYS];
+    uint64_t sent_mask;                         // Keys sent at least once
+    UserAchievementState* user;                 // Resolved once the user exists
+    uint64_t seen_version;
+    uint64_t interval_ms;
+    uint64_t next_due_ms;
+    int in_len;
+    int out_len;
+    int out_off;
+    uint8_t in_buf[sizeof(sweetexp_sub_request) + SWEETEXP_SUB_MAX_KEYS * sizeof(sweetexp_sub_key)];
+    uint8_t out_buf[sizeof(sweetexp_sub_frame) + SWEETEXP_SUB_MAX_KEYS * sizeof(sweetexp_sub_delta) + RANK_REPLY_MAX];
+} Subscriber;
+
+static Subscriber subscribers[MAX_SUBSCRIBERS];
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static int subscription_max_hz(void) {
+    int hz = engine.subscription_max_hz > 0 ? engine.subscription_max_hz : SUBSCRIPTION_DEFAULT_MAX_HZ;
+    return hz > SUBSCRIPTION_MAX_HZ_LIMIT ? SUBSCRIPTION_MAX_HZ_LIMIT : hz;
+}
+
+static void subscriber_close(int epfd, Subscriber* sub) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, sub->fd, NULL);
+    close(sub->fd);
+    memset(sub, 0, sizeof(*sub));
+    sub->fd = -1;
+}
+
+// Append the answer to a leaderboard query behind any unsent frame; returns bytes
+// consumed, 0 if incomplete or the output buffer has no room for a reply yet
+static int subscriber_answer_rank_query(Subscriber* sub) {
+    if (sub->in_len < (int)sizeof(sweetexp_rank_query)) return 0;
+    if (sub->out_len + RANK_REPLY_MAX > sizeof(sub->out_buf)) return 0;
+
+    sweetexp_rank_query query;
+    memcpy(&query, sub->in_buf, sizeof(query));
+    char name[sizeof(query.metric) + 1];
+    memcpy(name, query.metric, sizeof(query.metric));
+    name[sizeof(query.metric)] = '\0';
+    int metric = lookup_metric(name);
+
+    sweetexp_rank_reply reply = {SWEETEXP_RANK_MAGIC, query.op, 0, 0, 0};
+    sweetexp_rank_entry entries[SWEETEXP_RANK_MAX_ENTRIES];
+    int count = 0;
+    if (query.op == SWEETEXP_RANK_TOP) {
+        int max = query.count < SWEETEXP_RANK_MAX_ENTRIES ? query.count : SWEETEXP_RANK_MAX_ENTRIES;
+        count = leaderboard_top(metric, query.offset, entries, max, &reply.total);
+    } else if (query.op == SWEETEXP_RANK_OF_USER) {
+        count = leaderboard_rank(metric, query.user_id, entries, &reply.total) == 0;
+    }
+    reply.count = (uint16_t)count;
+
+    memcpy(sub->out_buf + sub->out_len, &reply, sizeof(reply));
+    memcpy(sub->out_buf + sub->out_len + sizeof(reply), entries, count * sizeof(entries[0]));
+    sub->out_len += (int)(sizeof(reply) + count * sizeof(entries[0]));
+    return (int)sizeof(query);
+}
+
+// Parse a complete request from the input buffer; returns bytes consumed, 0 if incomplete
+static int subscriber_parse_request(Subscriber* sub) {
+    uint32_t magic;
+    if (sub->in_len < (int)sizeof(magic)) return 0;
+    memcpy(&magic, sub->in_buf, sizeof(magic));
+    if (magic == SWEETEXP_RANK_MAGIC) return subscriber_answer_rank_query(sub);
+    if (sub->in_len < (int)sizeof(sweetexp_sub_request)) return 0;
+
+    sweetexp_sub_request req;
+    memcpy(&req, sub->in_buf, sizeof(req));
+    if (req.magic != SWEETEXP_SUB_MAGIC || req.key_count > SWEETEXP_SUB_MAX_KEYS) return -1;
+    int need = (int)(sizeof(req) + req.key_count * sizeof(sweetexp_sub_key));
+    if (sub->in_len < need) return 0;
+
+    const sweetexp_sub_key* keys = (const sweetexp_sub_key*)(sub->in_buf + sizeof(req));
+    sub->user_id = req.user_id;
+    sub->user = NULL;
+    sub->key_count = req.key_count;
+    sub->sent_mask = 0;
+    sub->seen_version = 0;
+    for (int i = 0; i < req.key_count; i++) {
+        char name[sizeof(keys[i].name) + 1];
+        memcpy(name, keys[i].name, sizeof(keys[i].name));
+        name[sizeof(keys[i].name)] = '\0';
+        sub->key_kind[i] = keys[i].kind;
+        if (keys[i].kind == SWEETEXP_KEY_ACHIEVEMENT) {
+            sub->key_ref[i] = find_achievement_index(name);
+        } else if (keys[i].kind == SWEETEXP_KEY_METRIC) {
+            sub->key_ref[i] = lookup_metric(name);
+        } else {
+            sub->key_ref[i] = -1;
+        }
+    }
+
+    int hz = req.max_rate_hz ? req.max_rate_hz : subscription_max_hz();
+    if (hz > subscription_max_hz()) hz = subscription_max_hz();
+    sub->interval_ms = 1000 / (uint64_t)hz;
+    sub->next_due_ms = 0;  // Full state on the next tick
+    return need;
+}
+
+static int subscriber_flush(int epfd, Subscriber* sub);
+
+// Handle every complete request in the input buffer; returns -1 if the client was closed
+static int subscriber_process_input(int epfd, Subscriber* sub) {
+    int used;
+    while ((used = subscriber_parse_request(sub)) > 0) {
+        memmove(sub->in_buf, sub->in_buf + used, sub->in_len - used);
+        sub->in_len -= used;
+    }
+    if (used < 0) {
+        subscriber_close(epfd, sub);
+        return -1;
+    }
+    if (sub->out_off < sub->out_len) subscriber_flush(epfd, sub);
+    return sub->fd >= 0 ? 0 : -1;
+}
+
+static void subscriber_read(int epfd, Subscriber* sub) {
+    for (;;) {
+        if (sub->in_len == (int)sizeof(sub->in_buf)) {
+            // Queries are waiting for reply space; read again once the output drains
+            struct epoll_event ev = {.events = EPOLLOUT, .data.ptr = sub};
+            epoll_ctl(epfd, EPOLL_CTL_MOD, sub->fd, &ev);
+            return;
+        }
+        ssize_t len = read(sub->fd, sub->in_buf + sub->in_len, sizeof(sub->in_buf) - sub->in_len);
+        if (len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR)) {
+            subscriber_close(epfd, sub);
+            return;
+        }
+        if (len < 0) return;
+        sub->in_len += (int)len;
+        if (subscriber_process_input(epfd, sub) < 0) return;
+    }
+}
+
+// Push out whatever is left of the output buffer; returns 1 once fully sent
+static int subscriber_flush(int epfd, Subscriber* sub) {
+    while (sub->out_off < sub->out_len) {
+        ssize_t len = send(sub->fd, sub->out_buf + sub->out_off, sub->out_len - sub->out_off, MSG_NOSIGNAL);
+        if (len < 0) {
+            if (errno == EAGAIN) {
+                struct epoll_event ev = {.events = EPOLLIN | EPOLLOUT, .data.ptr = sub};
+                epoll_ctl(epfd, EPOLL_CTL_MOD, sub->fd, &ev);
+                return 0;
+            }
+            if (errno == EINTR) continue;
+            subscriber_close(epfd, sub);
+            return 0;
+        }
+        sub->out_off += (int)len;
+    }
+    if (sub->out_len) {
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = sub};
+        epoll_ctl(epfd, EPOLL_CTL_MOD, sub->fd, &ev);
+    }
+    sub->out_len = sub->out_off = 0;
+    return 1;
+}
+
+// Build one frame with every subscribed value that changed since it was last sent
+static void subscriber_tick(int epfd, Subscriber* sub, uint64_t now_ms) {
+    if (sub->key_count == 0 || now_ms < sub->next_due_ms) return;
+    if (sub->out_len && !subscriber_flush(epfd, sub)) return;  // Still draining; values stay latest-only
+
+    AchievementShard* shard = &engine.shards[user_shard_index(sub->user_id)];
+    if (!sub->user) {
+        pthread_mutex_lock(&shard->lock);
+        sub->user = shard_find_user_locked(shard, sub->user_id, 0);
+        pthread_mutex_unlock(&shard->lock);
+        if (!sub->user) return;
+    }
+    uint64_t version = __atomic_load_n(&sub->user->version, __ATOMIC_ACQUIRE);
+    if (version == sub->seen_version && sub->sent_mask) return;
+
+    int64_t values[SWEETEXP_SUB_MAX_KEYS];
+    uint8_t unlocked[SWEETEXP_SUB_MAX_KEYS];
+    pthread_mutex_lock(&shard->lock);
+    for (int i = 0; i < sub->key_count; i++) {
+        int ref = sub->key_ref[i];
+        unlocked[i] = 0;
+        if (ref < 0) {
+            values[i] = 0;
+        } else if (sub->key_kind[i] == SWEETEXP_KEY_ACHIEVEMENT) {
+            values[i] = sub->user->progress[ref].progress;
+            unlocked[i] = (uint8_t)sub->user->progress[ref].unlocked;
+        } else {
+            values[i] = sub->user->metrics[ref];
+        }
+    }
+    version = sub->user->version;
+    pthread_mutex_unlock(&shard->lock);
+
+    sweetexp_sub_frame* frame = (sweetexp_sub_frame*)sub->out_buf;
+    sweetexp_sub_delta* deltas = (sweetexp_sub_delta*)(sub->out_buf + sizeof(*frame));
+    int count = 0;
+    for (int i = 0; i < sub->key_count; i++) {
+        uint64_t bit = (uint64_t)1 << i;
+        if (sub->key_ref[i] < 0) continue;
+        if ((sub->sent_mask & bit) && values[i] == sub->last_value[i] && unlocked[i] == sub->last_unlocked[i]) continue;
+        deltas[count].key = (uint16_t)i;
+        deltas[count].kind = sub->key_kind[i];
+        deltas[count].unlocked = unlocked[i];
+        deltas[count].target = sub->key_kind[i] == SWEETEXP_KEY_ACHIEVEMENT ? engine.achievements[sub->key_ref[i]].target : 0;
+        deltas[count].value = values[i];
+        sub->last_value[i] = values[i];
+        sub->last_unlocked[i] = unlocked[i];
+        sub->sent_mask |= bit;
+        count++;
+    }
+    sub->seen_version = version;
+    sub->next_due_ms = now_ms + sub->interval_ms;
+    if (count == 0) return;
+
+    frame->magic = SWEETEXP_SUB_MAGIC;
+    frame->count = (uint16_t)count;
+    frame->flags = 0;
+    frame->timestamp_ms = (uint64_t)time(NULL) * 1000;
+    sub->out_len = (int)(sizeof(*frame) + count * sizeof(sweetexp_sub_delta));
+    sub->out_off = 0;
+    subscriber_flush(epfd, sub);
+}
+
+// Subscription server: one epoll loop for the listener and every client
+void* subscription_server_thread(void* arg) {
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) return NULL;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SWEETEXP_SUBSCRIBE_SOCK, sizeof(addr.sun_path) - 1);
+    unlink(SWEETEXP_SUBSCRIBE_SOCK);
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, SOCKET_BACKLOG) < 0) {
+        fprintf(stderr, "SweetEngine: Subscription socket unavailable: %s\n", strerror(errno));
+        close(listen_fd);
+        return NULL;
+    }
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+    for (int i = 0; i < MAX_SUBSCRIBERS; i++) subscribers[i].fd = -1;
+
+    struct epoll_event events[MAX_SUBSCRIBERS + 1];
+    while (engine.enabled) {
+        int n = epoll_wait(epfd, events, MAX_SUBSCRIBERS + 1, 1000 / subscription_max_hz());
+        for (int i = 0; i < n; i++) {
+            Subscriber* sub = events[i].data.ptr;
+            if (!sub) {
+                int fd;
+                while ((fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    Subscriber* slot = NULL;
+                    for (int k = 0; k < MAX_SUBSCRIBERS && !slot; k++) {
+                        if (subscribers[k].fd < 0) slot = &subscribers[k];
+                    }
+                    if (!slot) {
+                        close(fd);
+                        continue;
+                    }
+                    memset(slot, 0, sizeof(*slot));
+                    slot->fd = fd;
+                    struct epoll_event cev = {.events = EPOLLIN, .data.ptr = slot};
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &cev);
+                }
+                continue;
+            }
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                subscriber_close(epfd, sub);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && subscriber_flush(epfd, sub) && sub->in_len) {
+                if (subscriber_process_input(epfd, sub) < 0) continue;
+            }
+            if (sub->fd >= 0 && (events[i].events & EPOLLIN)) subscriber_read(epfd, sub);
+        }
+
+        uint64_t now_ms = monotonic_ms();
+        for (int i = 0; i < MAX_SUBSCRIBERS; i++) {
+            if (subscribers[i].fd >= 0) subscriber_tick(epfd, &subscribers[i], now_ms);
+        }
+    }
+
+    for (int i = 0; i < MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].fd >= 0) subscriber_close(epfd, &subscribers[i]);
+    }
+    close(epfd);
+    close(listen_fd);
+    unlink(SWEETEXP_SUBSCRIBE_SOCK);
+    return NULL;
+}
+
+// ==================== EVENT INGESTION ====================
+// Compositor, kernel helpers and other daemons report real activity by streaming
+// sweetexp_ingest frames to SWEETEXP_INGEST_SOCK (see sweetexp_abi.h). One epoll
+// loop serves every client; each has its own receive buffer so partial frames
+// survive between reads. Events decoded from all clients that were ready in one
+// epoll round are applied with a single submit_metric_batch call. Slot bindings
+// are per connection, so a client resolves metric names once, not per event.
+
+typedef struct {
+    int fd;
+    int len;
+    int16_t slot_metric[SWEETEXP_INGEST_SLOTS];     // Metric id per client slot, -1 unbound
+    uint8_t buf[INGEST_CLIENT_BUFFER];
+} IngestClient;
+
+static IngestClient ingest_clients[MAX_INGEST_CLIENTS];
+
+static void ingest_client_close(int epfd, IngestClient* client) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    client->fd = -1;
+    client->len = 0;
+}
+
+// Decode every complete frame in the client's buffer, appending events to `batch`
+// (flushed through submit_metric_batch when full). Returns -1 on a malformed frame.
+static int ingest_client_parse(IngestClient* client, sweetexp_event* batch, uint32_t* batch_count) {
+    int off = 0;
+
+    while (client->len - off >= (int)sizeof(sweetexp_ingest_frame)) {
+        sweetexp_ingest_frame frame;
+        memcpy(&frame, client->buf + off, sizeof(frame));
+        if (frame.magic != SWEETEXP_INGEST_MAGIC || frame.count > SWEETEXP_INGEST_MAX_RECORDS) return -1;
+
+        size_t record_size;
+        if (frame.type == SWEETEXP_INGEST_EVENTS) record_size = sizeof(sweetexp_ingest_event);
+        else if (frame.type == SWEETEXP_INGEST_BIND) record_size = sizeof(sweetexp_ingest_bind);
+        else return -1;
+
+        int need = (int)(sizeof(frame) + frame.count * record_size);
+        if (client->len - off < need) break;
+        const uint8_t* records = client->buf + off + sizeof(frame);
+
+        if (frame.type == SWEETEXP_INGEST_EVENTS) {
+            if (*batch_count + frame.count > INGEST_BATCH) {
+                submit_metric_batch(batch, *batch_count);
+                *batch_count = 0;
+            }
+            for (int i = 0; i < frame.count; i++) {
+                sweetexp_ingest_event rec;
+                memcpy(&rec, records + i * sizeof(rec), sizeof(rec));
+                if (rec.slot >= SWEETEXP_INGEST_SLOTS || client->slot_metric[rec.slot] < 0) continue;
+                sweetexp_event* ev = &batch[(*batch_count)++];
+                ev->metric_id = (uint32_t)client->slot_metric[rec.slot];
+                ev->user_id = rec.user_id;
+                ev->delta = rec.delta;
+                ev->timestamp_ms = 0;
+            }
+        } else {
+            for (int i = 0; i < frame.count; i++) {
+                sweetexp_ingest_bind rec;
+                memcpy(&rec, records + i * sizeof(rec), sizeof(rec));
+                if (rec.slot >= SWEETEXP_INGEST_SLOTS) continue;
+                char name[sizeof(rec.name) + 1];
+                memcpy(name, rec.name, sizeof(rec.name));
+                name[sizeof(rec.name)] = '\0';
+                client->slot_metric[rec.slot] = (int16_t)register_metric(name);
+            }
+        }
+        off += need;
+    }
+
+    if (off) {
+        memmove(client->buf, client->buf + off, client->len - off);
+        client->len -= off;
     }
-    
     return 0;
 }
 
-// Log engine events
-void log_engine_event(const char* event) {
-    FILE* log = fopen("/lumen-motonexus6/fw/boot/main/k/sweetexp/engine.log", "a");
-    if (log) {
-        time_t now = time(NULL);
-        char* time_str = ctime(&now);
-        time_str[strlen(time_str) - 1] = '';  // Remove newline
-        fprintf(log, "[%s] %s
-", time_str, event);
-        fclose(log);
+static void ingest_client_read(int epfd, IngestClient* client, sweetexp_event* batch, uint32_t* batch_count) {
+    ssize_t len = read(client->fd, client->buf + client->len, sizeof(client->buf) - client->len);
+    if (len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR)) {
+        ingest_client_close(epfd, client);
+        return;
+    }
+    if (len < 0) return;
+    client->len += (int)len;
+    if (ingest_client_parse(client, batch, batch_count) < 0) {
+        fprintf(stderr, "SweetEngine: Dropping ingest client with malformed frame\n");
+        ingest_client_close(epfd, client);
+    }
+}
+
+static void ingest_accept(int epfd, int listen_fd) {
+    int fd;
+    while ((fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        IngestClient* slot = NULL;
+        for (int k = 0; k < MAX_INGEST_CLIENTS && !slot; k++) {
+            if (ingest_clients[k].fd < 0) slot = &ingest_clients[k];
+        }
+        if (!slot) {
+            close(fd);
+            continue;
+        }
+        slot->fd = fd;
+        slot->len = 0;
+        for (int m = 0; m < SWEETEXP_INGEST_SLOTS; m++) {
+            slot->slot_metric[m] = m < METRIC_BUILTIN_COUNT ? m : -1;
+        }
+        struct epoll_event cev = {.events = EPOLLIN, .data.ptr = slot};
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &cev);
+    }
+}
+
+// Ingestion server: one epoll loop for the listener and every client
+void* ingest_server_thread(void* arg) {
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) return NULL;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SWEETEXP_INGEST_SOCK, sizeof(addr.sun_path) - 1);
+    unlink(SWEETEXP_INGEST_SOCK);
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, SOMAXCONN) < 0) {
+        fprintf(stderr, "SweetEngine: Ingest socket unavailable: %s\n", strerror(errno));
+        close(listen_fd);
+        return NULL;
+    }
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+    for (int i = 0; i < MAX_INGEST_CLIENTS; i++) ingest_clients[i].fd = -1;
+
+    struct epoll_event events[MAX_INGEST_CLIENTS + 1];
+    sweetexp_event batch[INGEST_BATCH];
+    while (engine.enabled) {
+        int n = epoll_wait(epfd, events, MAX_INGEST_CLIENTS + 1, 1000);
+        uint32_t batch_count = 0;
+        for (int i = 0; i < n; i++) {
+            IngestClient* client = events[i].data.ptr;
+            if (!client) {
+                ingest_accept(epfd, listen_fd);
+            } else if (events[i].events & EPOLLIN) {
+                ingest_client_read(epfd, client, batch, &batch_count);
+            } else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                ingest_client_close(epfd, client);
+            }
+        }
+        if (batch_count) submit_metric_batch(batch, batch_count);
+    }
+
+    for (int i = 0; i < MAX_INGEST_CLIENTS; i++) {
+        if (ingest_clients[i].fd >= 0) ingest_client_close(epfd, &ingest_clients[i]);
+    }
+    close(epfd);
+    close(listen_fd);
+    unlink(SWEETEXP_INGEST_SOCK);
+    return NULL;
+}
+
+// ==================== EVENT PROVIDER PLUGINS ====================
+// Shared objects listed as PLUGIN=/path/lib.so in sweetexpengine.ini are dlopen'ed at
+// startup and must export SWEETEXP_PLUGIN_ENTRY (see sweetexp_abi.h). Plugins run their
+// own threads and push arrays of events through host.submit_batch, which goes straight
+// to submit_metric_batch so locking and evaluation are amortized across the batch.
+// Plugins listed after startup are picked up on the next engine restart.
+
+typedef struct {
+    void* handle;
+    const sweetexp_plugin* desc;
+    void* state;
+} LoadedPlugin;
+
+static LoadedPlugin plugins[MAX_PLUGINS];
+static int plugin_count = 0;
+
+static int host_submit_batch(const sweetexp_event* events, uint32_t count) {
+    return submit_metric_batch(events, count);
+}
+
+static void host_log(const char* message) {
+    log_engine_event(message);
+}
+
+static const sweetexp_host_api plugin_host_api = {
+    SWEETEXP_PLUGIN_ABI_VERSION,
+    sizeof(sweetexp_host_api),
+    register_metric,
+    host_submit_batch,
+    host_log,
+};
+
+int load_plugins(void) {
+    for (int i = 0; i < engine.plugin_path_count && plugin_count < MAX_PLUGINS; i++) {
+        const char* path = engine.plugin_paths[i];
+        void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+        if (!handle) {
+            fprintf(stderr, "SweetEngine: Plugin %s: %s\n", path, dlerror());
+            continue;
+        }
+
+        sweetexp_plugin_entry_fn entry = (sweetexp_plugin_entry_fn)dlsym(handle, SWEETEXP_PLUGIN_ENTRY);
+        const sweetexp_plugin* desc = entry ? entry() : NULL;
+        if (!desc || desc->abi_version != SWEETEXP_PLUGIN_ABI_VERSION || !desc->start) {
+            fprintf(stderr, "SweetEngine: Plugin %s: missing entry or ABI mismatch\n", path);
+            dlclose(handle);
+            continue;
+        }
+
+        void* state = NULL;
+        if (desc->start(&plugin_host_api, &state) != 0) {
+            fprintf(stderr, "SweetEngine: Plugin %s failed to start\n", path);
+            dlclose(handle);
+            continue;
+        }
+
+        plugins[plugin_count].handle = handle;
+        plugins[plugin_count].desc = desc;
+        plugins[plugin_count].state = state;
+        plugin_count++;
+        log_engine_eventf("Plugin loaded: %s (%s)", desc->name ? desc->name : "?", path);
     }
+    return plugin_count;
 }
 
-// Signal handler for clean shutdown
+void unload_plugins(void) {
+    for (int i = plugin_count - 1; i >= 0; i--) {
+        if (plugins[i].desc->stop) plugins[i].desc->stop(plugins[i].state);
+        dlclose(plugins[i].handle);
+    }
+    plugin_count = 0;
+}
+
+// Set by SIGINT/SIGTERM; main's loop notices it and runs the normal shutdown
+static volatile sig_atomic_t shutdown_signal;
+
+// Signal handler for clean shutdown: only async-signal-safe work here. Saving
+// takes the group-commit, journal and shard locks, which the interrupted thread
+// may hold, so the final save is left to main.
 void signal_handler(int sig) {
-    printf("SweetEngine: Received signal %d, shutting down
-", sig);
-    engine.enabled = 0;
-    save_engine_data();
-    exit(0);
+    shutdown_signal = sig;
 }
 
-int main(void) {
-    printf("SweetExperiencesEngine starting...
-");
+int main(int argc, char** argv) {
+    printf("SweetExperiencesEngine starting...\n");
     
     // Initialize
     pthread_mutex_init(&engine.data_mutex, NULL);
@@ -447,47 +4871,92 @@ int main(void) {
     
     // Load configuration
     if (!load_config()) {
-        printf("SweetEngine: Disabled by config
-");
+        printf("SweetEngine: Disabled by config\n");
         return 0;
     }
+    init_engine_logger();  // After the config: LOG_FORMAT picks the file
     
     // Load persistent data
+    init_achievement_shards();
+    init_leaderboards();
+    init_metric_rollups();
+    init_proc_metrics();
+    init_progress_snapshot();
     load_engine_data();
+    reevaluate_all_achievements();  // Catch up on definitions or values changed while stopped
+    refresh_notification_filters();
+
+    // One-shot maintenance mode: replay history, persist and exit
+    if (argc > 1 && strcmp(argv[1], "--backfill") == 0) {
+        int unlocked = backfill_history(argc > 2 ? atoi(argv[2]) : 0, argc > 3 ? atoi(argv[3]) : 0);
+        save_engine_data();
+        printf("SweetEngine: Backfill unlocked %d achievements\n", unlocked);
+        return unlocked < 0 ? 1 : 0;
+    }
     
-    printf("SweetEngine: Initialized with %d achievements
-", engine.achievement_count);
+    printf("SweetEngine: Initialized with %d achievements\n", engine.achievement_count);
+    start_engine_logger();
     log_engine_event("Engine started");
     
+    // Restore scheduled notifications
+    int timers_ready = (init_timer_wheel() == 0);
+    
     // Start threads
+    start_persist_writer();
+    start_sqlite_sink();
     pthread_create(&engine.achievement_thread, NULL, achievement_monitor_thread, NULL);
     pthread_create(&engine.notification_thread, NULL, notification_dispatcher_thread, NULL);
-    pthread_create(&engine.wayland_listener, NULL, wayland_event_listener, NULL);
-    pthread_create(&engine.kernel_hook, NULL, kernel_hook_listener, NULL);
+    pthread_create(&engine.ingest_thread, NULL, ingest_server_thread, NULL);
+    pthread_create(&engine.proc_sampler, NULL, proc_sampler_thread, NULL);
+    if (timers_ready) {
+        pthread_create(&engine.timer_thread, NULL, timer_wheel_thread, NULL);
+    }
+    pthread_create(&engine.subscription_thread, NULL, subscription_server_thread, NULL);
+    load_plugins();
     
-    // Main loop - monitor config changes
-    int inotify_fd = inotify_init();
-    inotify_add_watch(inotify_fd, dirname(SWEETEXP_INI_PATH), IN_MODIFY);
+    // Main loop - monitor config changes (non-blocking, so a signal is seen within 100ms)
+    int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    char ini_dir[] = SWEETEXP_INI_PATH;  // dirname() writes into its argument
+    if (inotify_fd < 0) {
+        fprintf(stderr, "SweetEngine: Cannot watch config, reload disabled: %s\n", strerror(errno));
+    } else if (inotify_add_watch(inotify_fd, dirname(ini_dir), IN_MODIFY) < 0) {
+        fprintf(stderr, "SweetEngine: Cannot watch %s, reload disabled: %s\n", ini_dir, strerror(errno));
+    }
     
     char buffer[INOTIFY_BUFFER_SIZE];
-    while (engine.enabled) {
-        ssize_t len = read(inotify_fd, buffer, sizeof(buffer));
+    while (engine.enabled && !shutdown_signal) {
+        ssize_t len = inotify_fd >= 0 ? read(inotify_fd, buffer, sizeof(buffer)) : 0;
         if (len > 0) {
             load_config();  // Reload config on change
         }
         usleep(100000);  // 100ms
     }
+    if (shutdown_signal) {
+        printf("SweetEngine: Received signal %d, shutting down\n", (int)shutdown_signal);
+    }
+    engine.enabled = 0;  // Worker loops exit within their poll interval
+    if (inotify_fd >= 0) close(inotify_fd);
     
     // Cleanup
+    unload_plugins();
+    flush_notification_digests(1);
     pthread_join(engine.achievement_thread, NULL);
     pthread_join(engine.notification_thread, NULL);
-    pthread_join(engine.wayland_listener, NULL);
-    pthread_join(engine.kernel_hook, NULL);
+    pthread_join(engine.ingest_thread, NULL);
+    pthread_join(engine.proc_sampler, NULL);
+    if (timers_ready) {
+        wake_timer_wheel();
+        pthread_join(engine.timer_thread, NULL);
+    }
+    pthread_join(engine.subscription_thread, NULL);
+    stop_persist_writer();  // After every producer is gone
+    save_engine_data();     // Final snapshot; no thread holds an engine lock now
+    stop_sqlite_sink();     // Last: the writer's announcements feed it
     
     pthread_mutex_destroy(&engine.data_mutex);
     log_engine_event("Engine stopped");
+    stop_engine_logger();
     
-    printf("SweetEngine: Shutdown complete
-");
+    printf("SweetEngine: Shutdown complete\n");
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+/**
+ * lumenlog.h - Shared asynchronous logger for the Lumen daemons
+ * SweetExperiencesEngine and BootSecurityManager log through one library
+ * (LumenLog.c): a call formats straight into its thread's staging buffer and
+ * returns; one flusher thread per process merges every thread's records in
+ * sequence order and hands them in batches to the registered sinks. Before
+ * lumenlog_start() and after lumenlog_stop() calls write to the sinks directly.
+ * In binary mode a call stages the format pointer and the raw argument bytes
+ * instead of text; lumenlog_binary_file_sink() stores them as is and the offline
+ * decoder (LumenLogDecoder.c) renders them.
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ */
+
+#ifndef LUMENLOG_H
+#define LUMENLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+#define LUMENLOG_MAX_TEXT 1024          // Longer messages are cut
+#define LUMENLOG_MAX_TAG 32
+
+typedef enum {
+    LUMENLOG_DEBUG = 0,
+    LUMENLOG_INFO,
+    LUMENLOG_WARNING,
+    LUMENLOG_ERROR,
+    LUMENLOG_CRITICAL,
+    LUMENLOG_LEVELS
+} lumenlog_level;
+
+// What a call does when its thread's staging buffer is full
+typedef enum {
+    LUMENLOG_OVERFLOW_DROP = 0,         // Count it; the flusher logs the total
+    LUMENLOG_OVERFLOW_BLOCK,            // Wait for the flusher to make room
+    LUMENLOG_OVERFLOW_SYNC              // Write it to the sinks directly, possibly out of order
+} lumenlog_overflow;
+
+// One message as a sink sees it; tag and text are not NUL terminated. A record
+// staged in binary mode has fmt and args instead of text; text sinks get it with
+// the text rendered, binary sinks as staged.
+typedef struct {
+    uint64_t seq;                       // Process-wide call order
+    int64_t when_ns;                    // CLOCK_REALTIME
+    lumenlog_level level;
+    uint32_t tag_len;
+    uint32_t text_len;
+    const char* tag;
+    const char* text;
+    uint32_t thread_id;
+    uint32_t args_len;
+    const char* fmt;                    // Binary records only
+    const void* args;                   // Encoded as in BINARY LOG FORMAT
+} lumenlog_record;
+
+// A destination. write() gets records in sequence order, from one thread at a
+// time, and only those passing min_level and tag (NULL = any tag).
+typedef struct lumenlog_sink {
+    const char* name;
+    lumenlog_level min_level;
+    const char* tag;
+    void (*write)(struct lumenlog_sink* sink, const lumenlog_record* records, int count);
+    void* ctx;
+    int binary;                         // Takes binary records without rendering them
+} lumenlog_sink;
+
+// Calls below the level return at once (default LUMENLOG_DEBUG)
+void lumenlog_set_level(lumenlog_level level);
+void lumenlog_set_overflow(lumenlog_overflow policy);
+// Calls at or above the level return only once their record reached the sinks,
+// for messages that must not be lost if the process hangs next (default off)
+void lumenlog_set_sync_level(lumenlog_level level);
+// Binary mode (default off): calls stage fmt and the raw arguments instead of
+// text, so fmt must stay valid until flushed (a string literal). Formats the
+// encoding cannot carry (%n, %m, %ls, %lc, %Lf, positional arguments) are staged
+// as text.
+void lumenlog_set_binary(int enabled);
+const char* lumenlog_level_name(lumenlog_level level);
+// "DEBUG", "INFO", "WARNING", "ERROR", "CRITICAL"; anything else is LUMENLOG_INFO
+lumenlog_level lumenlog_level_from_name(const char* name);
+
+// Register a sink (at most 8, kept for the life of the process); 0 or -1
+int lumenlog_add_sink(lumenlog_sink* sink);
+// Appends "[ctime] LEVEL tag: text" lines to `path` through one O_APPEND fd
+lumenlog_sink* lumenlog_file_sink(const char* path);
+// Calls fn for every record, e.g. to forward to lumen_log() or a UART
+lumenlog_sink* lumenlog_callback_sink(const char* name, void (*fn)(const lumenlog_record* record, void* arg), void* arg);
+// Keeps the newest lines in `memory` (size bytes, owned by the caller)
+lumenlog_sink* lumenlog_ring_sink(void* memory, size_t size);
+// Copies the ring's whole lines, oldest first, NUL terminated; returns the length
+size_t lumenlog_ring_sink_read(lumenlog_sink* sink, char* out, size_t size);
+// "[ctime] LEVEL tag: text\n", cut to fit; returns the length
+size_t lumenlog_format_line(const lumenlog_record* record, char* buf, size_t size);
+// Appends BINARY LOG FORMAT records to `path`, starting with a SESSION record
+lumenlog_sink* lumenlog_binary_file_sink(const char* path);
+// Renders encoded arguments through fmt like vsnprintf; NUL terminated, returns the length
+size_t lumenlog_render(const char* fmt, const void* args, size_t args_len, char* buf, size_t size);
+
+int lumenlog_start(void);
+// Blocks until everything logged before the call reached the sinks
+void lumenlog_flush(void);
+// Writes what is staged, then stops the flusher; call once producers are done.
+// lumenlog_start() also runs it at exit(), so error paths that exit keep their lines.
+void lumenlog_stop(void);
+
+void lumenlog_write(lumenlog_level level, const char* tag, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+void lumenlog_vwrite(lumenlog_level level, const char* tag, const char* fmt, va_list args)
+    __attribute__((format(printf, 3, 0)));
+
+// ==================== BINARY LOG FORMAT ====================
+// A sequence of records, each a lumenlog_bin_header followed by its body, packed
+// without padding (read them with memcpy). Every process opening the file first
+// appends a SESSION record; FORMAT ids hold until the next SESSION. Arguments are
+// stored in fmt's order, little endian as on every Lumen target, with fixed
+// widths so a log decodes on any host: 4 bytes per int-sized conversion and per
+// '*', 8 per long, long long, size_t, pointer and double, and a uint16 length
+// plus the bytes (cut to the precision) per %s.
+//
+//   SESSION  header (when_ns = start, thread_id = pid), LUMENLOG_BIN_MAGIC
+//   FORMAT   header, uint16 id, uint16 tag_len, uint16 fmt_len, tag, fmt
+//   MESSAGE  header, uint16 id, arguments
+//   TEXT     header, uint16 tag_len, tag, text      (messages staged as text)
+
+#define LUMENLOG_BIN_MAGIC "LUMENLB1"   // 8 bytes, no NUL
+
+enum {
+    LUMENLOG_BIN_SESSION = 1,
+    LUMENLOG_BIN_FORMAT,
+    LUMENLOG_BIN_MESSAGE,
+    LUMENLOG_BIN_TEXT
+};
+
+typedef struct {
+    int64_t when_ns;                    // CLOCK_REALTIME
+    uint32_t thread_id;
+    uint16_t size;                      // Whole record, this header included
+    uint8_t type;
+    uint8_t level;                      // MESSAGE, TEXT
+} lumenlog_bin_header;
+
+// ==================== LEVEL MACROS ====================
+// LLOG_DEBUG(tag, fmt, ...) and friends log only when the level is at or above
+// both floors. The build-time floor LUMENLOG_COMPILE_LEVEL (0 = DEBUG ..
+// 4 = CRITICAL; e.g. -DLUMENLOG_COMPILE_LEVEL=1 drops DEBUG) is a constant, so
+// a call below it folds to nothing and its arguments are never evaluated. It is
+// read where the macro is used, so a file may set it before including this
+// header. Above it, one relaxed load of the lumenlog_set_level() floor decides
+// before any formatting happens.
+
+#ifndef LUMENLOG_COMPILE_LEVEL
+#define LUMENLOG_COMPILE_LEVEL 0
+#endif
+
+extern int lumenlog_runtime_level;      // Written by lumenlog_set_level()
+
+static inline int lumenlog_enabled(lumenlog_level level) {
+    return (int)level >= __atomic_load_n(&lumenlog_runtime_level, __ATOMIC_RELAXED);
+}
+
+#define LLOG(level, tag, ...) \
+    do { \
+        if ((int)(level) >= LUMENLOG_COMPILE_LEVEL && lumenlog_enabled(level)) \
+            lumenlog_write((level), (tag), __VA_ARGS__); \
+    } while (0)
+
+#define LLOG_DEBUG(tag, ...) LLOG(LUMENLOG_DEBUG, tag, __VA_ARGS__)
+#define LLOG_INFO(tag, ...) LLOG(LUMENLOG_INFO, tag, __VA_ARGS__)
+#define LLOG_WARNING(tag, ...) LLOG(LUMENLOG_WARNING, tag, __VA_ARGS__)
+#define LLOG_ERROR(tag, ...) LLOG(LUMENLOG_ERROR, tag, __VA_ARGS__)
+#define LLOG_CRITICAL(tag, ...) LLOG(LUMENLOG_CRITICAL, tag, __VA_ARGS__)
+
+#endif // LUMENLOG_H
@@ -0,0 +1,506 @@
+/**
+ * sweetexp_abi.h - Shared layouts between SweetExperiencesEngine and its clients
+ * Everything here is read by processes other than SweetEngine (GUI, tools),
+ * so layouts are fixed-width and only ever extended by bumping the version.
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ */
+
+#ifndef SWEETEXP_ABI_H
+#define SWEETEXP_ABI_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ==================== ACHIEVEMENT PROGRESS SNAPSHOT ====================
+// Read-only shared memory table published by SweetEngine (shm_open name below,
+// i.e. /dev/shm/sweetexp_progress). Each entry is guarded by its own seqlock:
+// the engine makes `seq` odd, updates the fields, then store-releases an even
+// `seq`. Readers map the object PROT_READ and copy entries with
+// sweetexp_shm_read_entry(); no syscalls or locks are needed after mmap.
+// Scan min(entry_count, capacity) slots; a changed `epoch` means the engine
+// restarted and slot assignments must be re-read.
+
+#define SWEETEXP_SHM_NAME "/sweetexp_progress"
+#define SWEETEXP_SHM_MAGIC 0x53585053u  // "SPXS"
+#define SWEETEXP_SHM_VERSION 1
+#define SWEETEXP_SHM_MAX_ENTRIES 4096
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t entry_size;
+    uint32_t capacity;
+    uint32_t entry_count;       // Slots handed out so far (acquire-load before scanning)
+    uint32_t epoch;             // Bumped each time the engine (re)initializes the table
+    uint32_t writer_pid;
+    uint8_t reserved[32];
+} __attribute__((aligned(64))) sweetexp_shm_header;
+
+typedef struct {
+    uint32_t seq;               // 0 = never published, odd = update in progress
+    int32_t user_id;
+    int32_t progress;
+    int32_t target;
+    int64_t unlock_time;
+    uint32_t unlocked;
+    int32_t metric;
+    char achievement_id[32];    // Immutable once the slot is published
+} __attribute__((aligned(64))) sweetexp_shm_entry;
+
+typedef struct {
+    sweetexp_shm_header header;
+    sweetexp_shm_entry entries[SWEETEXP_SHM_MAX_ENTRIES];
+} sweetexp_shm_table;
+
+// Copy one entry consistently. Returns 1 on success, 0 if the slot is unpublished.
+static inline int sweetexp_shm_read_entry(const sweetexp_shm_entry* e, sweetexp_shm_entry* out) {
+    for (;;) {
+        uint32_t s1 = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+        if (s1 == 0) return 0;
+        if (s1 & 1) continue;   // Writer mid-update
+        out->user_id = __atomic_load_n(&e->user_id, __ATOMIC_RELAXED);
+        out->progress = __atomic_load_n(&e->progress, __ATOMIC_RELAXED);
+        out->target = __atomic_load_n(&e->target, __ATOMIC_RELAXED);
+        out->unlock_time = __atomic_load_n(&e->unlock_time, __ATOMIC_RELAXED);
+        out->unlocked = __atomic_load_n(&e->unlocked, __ATOMIC_RELAXED);
+        out->metric = __atomic_load_n(&e->metric, __ATOMIC_RELAXED);
+        memcpy(out->achievement_id, e->achievement_id, sizeof(out->achievement_id));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&e->seq, __ATOMIC_RELAXED) == s1) {
+            out->seq = s1;
+            return 1;
+        }
+    }
+}
+
+// ==================== PROGRESS SUBSCRIPTIONS ====================
+// Stream socket at /tmp/sweetexp_progress.sock. The client writes one
+// sweetexp_sub_request followed by key_count sweetexp_sub_key entries (a new
+// request replaces the previous subscription). The engine answers with frames:
+// a sweetexp_sub_frame header and `count` sweetexp_sub_delta records, each
+// carrying the latest value of a key that changed since the previous frame.
+// The first frame after a request carries every known key. Unknown names are
+// never reported. Frames arrive at most max_rate_hz times per second (capped by
+// SUBSCRIPTION_MAX_HZ in sweetexpengine.ini); a slow reader skips intermediate
+// values rather than receiving a backlog.
+
+#define SWEETEXP_SUB_MAGIC 0x53425553u  // "SUBS"
+#define SWEETEXP_SUB_VERSION 1
+#define SWEETEXP_SUB_MAX_KEYS 64
+
+enum {
+    SWEETEXP_KEY_ACHIEVEMENT = 1,
+    SWEETEXP_KEY_METRIC = 2
+};
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t key_count;
+    int32_t user_id;
+    uint16_t max_rate_hz;       // 0 = engine maximum
+    uint16_t reserved;
+} sweetexp_sub_request;
+
+typedef struct {
+    uint8_t kind;               // SWEETEXP_KEY_*
+    char name[31];              // Achievement id or metric name, NUL padded
+} sweetexp_sub_key;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t count;
+    uint16_t flags;
+    uint64_t timestamp_ms;
+} sweetexp_sub_frame;
+
+typedef struct {
+    uint16_t key;               // Index into the request's key list
+    uint8_t kind;
+    uint8_t unlocked;
+    int32_t target;             // Achievement target, 0 for metrics
+    int64_t value;              // Progress or metric value
+} sweetexp_sub_delta;
+
+// ==================== LEADERBOARD QUERIES ====================
+// Also sent on the subscription socket, any time and without affecting the
+// subscription: a sweetexp_rank_query is answered by one sweetexp_rank_reply
+// followed by `count` sweetexp_rank_entry records. Replies and subscription
+// frames share the stream; tell them apart by magic. RANK_TOP returns up to
+// `count` users from 0-based rank `offset`; RANK_OF_USER returns the entry of
+// `user_id` (count 0 if unranked). `total` is the number of ranked users.
+// Ranking is by metric value, highest first, ties by lower user id.
+
+#define SWEETEXP_RANK_MAGIC 0x4B4E4152u  // "RANK"
+#define SWEETEXP_RANK_MAX_ENTRIES 64
+
+enum {
+    SWEETEXP_RANK_TOP = 1,
+    SWEETEXP_RANK_OF_USER = 2
+};
+
+typedef struct {
+    uint32_t magic;
+    uint16_t op;                // SWEETEXP_RANK_*
+    uint16_t count;             // RANK_TOP: entries wanted, capped at SWEETEXP_RANK_MAX_ENTRIES
+    uint32_t offset;            // RANK_TOP: first rank, 0-based
+    int32_t user_id;            // RANK_OF_USER
+    char metric[32];            // Metric name, NUL padded
+} sweetexp_rank_query;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t op;
+    uint16_t count;
+    uint32_t total;
+    uint32_t reserved;
+} sweetexp_rank_reply;
+
+typedef struct {
+    uint32_t rank;              // 1-based
+    int32_t user_id;
+    int64_t value;
+} sweetexp_rank_entry;
+
+// ==================== METRIC ROLLUP RINGS ====================
+// Fixed-size circular files under SWEETEXP_ROLLUP_DIR, one per resolution
+// (sweetexp_rollup_1m.dat, _1h.dat, _1d.dat): a header followed by slot_count
+// slots. The slot for bucket B (a multiple of resolution_sec) is
+// (B / resolution_sec) % slot_count; it belongs to B only if bucket_start == B.
+// Cell m holds count/sum/min/max of the samples of metric_names[m].
+
+#define SWEETEXP_ROLLUP_DIR "/lumen-motonexus6/fw/boot/main/k/sweetexp/data"
+#define SWEETEXP_ROLLUP_MAGIC 0x4C4C5253u  // "SRLL"
+#define SWEETEXP_ROLLUP_VERSION 1
+#define SWEETEXP_ROLLUP_METRICS 32
+#define SWEETEXP_ROLLUP_NAME_LEN 32
+
+typedef struct {
+    uint64_t count;
+    int64_t sum;
+    int64_t min;
+    int64_t max;
+} sweetexp_rollup_cell;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t resolution_sec;
+    uint32_t slot_count;
+    uint32_t metric_capacity;
+    uint32_t header_size;
+    uint32_t slot_size;
+    uint32_t reserved;
+    char metric_names[SWEETEXP_ROLLUP_METRICS][SWEETEXP_ROLLUP_NAME_LEN];
+} sweetexp_rollup_header;
+
+typedef struct {
+    int64_t bucket_start;       // Unix time of the bucket, 0 if never used
+    int64_t reserved;
+    sweetexp_rollup_cell cells[SWEETEXP_ROLLUP_METRICS];
+} sweetexp_rollup_slot;
+
+// ==================== ENGINE DATA FILE ====================
+// sweetexp_enginedata.dat, format v2: a sweetexp_data_header followed by the
+// sections it lists, each an array of fixed-width little-endian records at an
+// 8-byte aligned offset, and finally a string table of NUL-terminated strings
+// that records point into by byte offset. A reader maps the file, checks magic,
+// version, file_size and crc32 (of every byte after the header) and then indexes
+// records directly; records are walked with the stored record_size so newer
+// writers may append fields. Metric and achievement fields in records are
+// indexes into the file's own METRICS and ACHIEVEMENTS sections. Files starting
+// with "SWEETENGINE_DATA_v1" are the older line-based text format.
+
+#define SWEETEXP_DATA_MAGIC "SWEETENGINE_DATA_v2\n"
+#define SWEETEXP_DATA_VERSION 2
+#define SWEETEXP_DATA_DAY_WORDS 6
+#define SWEETEXP_DATA_HOUR_WORDS 3
+
+enum {
+    SWEETEXP_DATA_METRICS = 0,      // sweetexp_data_metric
+    SWEETEXP_DATA_ACHIEVEMENTS,     // sweetexp_data_achievement
+    SWEETEXP_DATA_PROGRESS,         // sweetexp_data_progress
+    SWEETEXP_DATA_VALUES,           // sweetexp_data_value
+    SWEETEXP_DATA_ACTIVITY,         // sweetexp_data_activity
+    SWEETEXP_DATA_STRINGS,          // Bytes; record_size 1
+    SWEETEXP_DATA_SECTIONS
+};
+
+typedef struct {
+    uint64_t offset;
+    uint32_t count;
+    uint32_t record_size;
+} sweetexp_data_section;
+
+typedef struct {
+    char magic[20];                 // SWEETEXP_DATA_MAGIC, not NUL terminated
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t crc32;
+    uint64_t file_size;
+    sweetexp_data_section sections[SWEETEXP_DATA_SECTIONS];
+} sweetexp_data_header;
+
+typedef struct {
+    uint32_t name;                  // String offset
+} sweetexp_data_metric;
+
+typedef struct {
+    uint32_t id;                    // String offsets
+    uint32_t name;
+    uint32_t description;
+    int32_t target;
+    int32_t metric;                 // Metric index, -1 if manual only
+    int32_t kind;
+    uint64_t reserved;
+} sweetexp_data_achievement;
+
+typedef struct {
+    int32_t user_id;
+    uint32_t achievement;
+    int32_t progress;
+    uint32_t unlocked;
+    int64_t unlock_time;
+} sweetexp_data_progress;
+
+typedef struct {
+    int32_t user_id;
+    uint32_t metric;
+    int64_t value;
+} sweetexp_data_value;
+
+typedef struct {
+    int32_t user_id;
+    uint32_t metric;
+    int32_t last_day;
+    int32_t last_hour;
+    uint64_t days[SWEETEXP_DATA_DAY_WORDS];
+    uint64_t hours[SWEETEXP_DATA_HOUR_WORDS];
+} sweetexp_data_activity;
+
+// CRC-32 (IEEE, reflected), half-byte table; pass 0 to start
+static inline uint32_t sweetexp_crc32(uint32_t crc, const void* data, size_t len) {
+    static const uint32_t table[16] = {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+        0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+    };
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 4) ^ table[(crc ^ p[i]) & 0x0F];
+        crc = (crc >> 4) ^ table[(crc ^ (p[i] >> 4)) & 0x0F];
+    }
+    return ~crc;
+}
+
+// ==================== NOTIFICATION HISTORY SEGMENT ====================
+// NotifEngine appends one JSON line per delivered notification to
+// notif_data.dat. SweetExpHistCompact moves those lines into notif_data.seg: a
+// sweetexp_hist_header, the lines themselves sorted by "timestamp" (verbatim,
+// '\n' terminated), then a sparse index with one entry every index_stride
+// records. A reader binary-searches the index and reads forward from there, so
+// "since T" and "last N" touch only the lines they return. crc32 covers the
+// header up to crc32 plus the index; lines are checked by parsing them.
+// Compaction first renames notif_data.dat to notif_data.dat.compacting, so
+// NotifEngine's next append starts a fresh log, and deletes it once the new
+// segment is in place; consumed_inode/size identify a .compacting file left by
+// a crash that the segment already contains. notif_data.dat thus only holds
+// lines appended since the last compaction.
+
+#define SWEETEXP_HIST_LOG_PATH "/lumen-motonexus6/system/notif/notif_data.dat"
+#define SWEETEXP_HIST_SEGMENT_PATH "/lumen-motonexus6/system/notif/notif_data.seg"
+#define SWEETEXP_HIST_MAGIC "SWEETEXP_HIST1\n"
+#define SWEETEXP_HIST_VERSION 1
+// Days of history compaction keeps by default; backfill replays the same window,
+// so a default compaction never drops lines a default backfill would count
+#define SWEETEXP_HIST_RETENTION_DAYS 365
+
+typedef struct {
+    char magic[16];             // SWEETEXP_HIST_MAGIC, NUL padded
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t record_count;
+    uint64_t data_offset;       // Sorted lines
+    uint64_t data_size;
+    uint64_t index_offset;      // sweetexp_hist_index[index_count], 8-byte aligned
+    uint32_t index_count;
+    uint32_t index_stride;      // Records per index entry
+    int64_t first_timestamp;
+    int64_t last_timestamp;
+    int64_t compacted_at;
+    int64_t retention_cutoff;   // Older lines were dropped or archived
+    uint64_t consumed_inode;    // notif_data.dat.compacting this segment absorbed
+    uint64_t consumed_size;
+    uint32_t crc32;
+    uint32_t reserved;
+} sweetexp_hist_header;
+
+typedef struct {
+    int64_t timestamp;          // Of the record below
+    uint64_t record;            // Record number, a multiple of index_stride
+    uint64_t offset;            // Its byte offset from data_offset
+} sweetexp_hist_index;
+
+// Header of a mapped segment of `size` bytes, or NULL if it is not a valid one
+static inline const sweetexp_hist_header* sweetexp_hist_validate(const void* base, size_t size) {
+    const sweetexp_hist_header* h = (const sweetexp_hist_header*)base;
+    if (!h || size < sizeof(*h) || memcmp(h->magic, SWEETEXP_HIST_MAGIC, sizeof(SWEETEXP_HIST_MAGIC) - 1) != 0 ||
+        h->version != SWEETEXP_HIST_VERSION || h->header_size < sizeof(*h) || h->index_stride == 0 ||
+        h->data_offset > size || h->data_size > size - h->data_offset || h->index_offset % 8 ||
+        h->index_offset > size || (uint64_t)h->index_count * sizeof(sweetexp_hist_index) > size - h->index_offset) {
+        return NULL;
+    }
+    uint32_t crc = sweetexp_crc32(0, h, offsetof(sweetexp_hist_header, crc32));
+    crc = sweetexp_crc32(crc, (const char*)base + h->index_offset, (size_t)h->index_count * sizeof(sweetexp_hist_index));
+    return crc == h->crc32 ? h : NULL;
+}
+
+// Index entry to read forward from for the first record at or after `since`
+// (the last one older than it), or NULL for an empty segment
+static inline const sweetexp_hist_index* sweetexp_hist_seek(const sweetexp_hist_index* index, uint32_t count,
+                                                            int64_t since) {
+    if (count == 0) return NULL;
+    uint32_t lo = 0, hi = count;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index[mid].timestamp < since) lo = mid;
+        else hi = mid;
+    }
+    return &index[lo];
+}
+
+// ==================== EVENT PROVIDER PLUGIN ABI ====================
+// A provider is a shared object listed as PLUGIN=/path/lib.so in
+// sweetexpengine.ini. It exports `sweetexp_plugin_entry`, returning a static
+// descriptor. start() receives the host API, starts the plugin's own threads
+// and returns 0; stop() must join them. Events should be pushed in batches:
+// one submit_batch call takes each engine lock once for the whole array.
+
+#define SWEETEXP_PLUGIN_ABI_VERSION 1
+#define SWEETEXP_PLUGIN_ENTRY "sweetexp_plugin_entry"
+
+typedef struct {
+    uint32_t metric_id;         // From host->register_metric()
+    int32_t user_id;            // 0 = system user
+    int64_t delta;              // Added to the metric; the new value for a gauge
+    int64_t timestamp_ms;       // Unix time in ms, 0 = now
+} sweetexp_event;
+
+typedef struct {
+    uint32_t abi_version;
+    uint32_t struct_size;
+    int (*register_metric)(const char* name);
+    int (*submit_batch)(const sweetexp_event* events, uint32_t count);
+    void (*log)(const char* message);
+} sweetexp_host_api;
+
+typedef struct {
+    uint32_t abi_version;       // SWEETEXP_PLUGIN_ABI_VERSION
+    const char* name;
+    int (*start)(const sweetexp_host_api* host, void** state);
+    void (*stop)(void* state);
+} sweetexp_plugin;
+
+typedef const sweetexp_plugin* (*sweetexp_plugin_entry_fn)(void);
+
+// ==================== EVENT INGESTION ====================
+// Stream socket at SWEETEXP_INGEST_SOCK shared by any number of local clients.
+// A client writes frames: a sweetexp_ingest_frame header followed by `count`
+// records of the type given by `type`. BIND records map a client-chosen slot
+// to a metric name (registered if new); EVENTS records add `delta` to the
+// metric bound to `slot` for `user_id`. Slots start bound to the builtin
+// metric ids below; events on unbound slots are dropped. Nothing is sent back,
+// and a malformed frame closes the connection. Pack many records per frame.
+
+#define SWEETEXP_INGEST_SOCK "/tmp/sweetexp_ingest.sock"
+#define SWEETEXP_INGEST_MAGIC 0x54534749u  // "IGST"
+#define SWEETEXP_INGEST_MAX_RECORDS 256
+#define SWEETEXP_INGEST_SLOTS 64
+
+enum {
+    SWEETEXP_METRIC_BOOT_COUNT = 0,
+    SWEETEXP_METRIC_WAYLAND_EVENTS = 1,
+    SWEETEXP_METRIC_NOTIFICATIONS_SENT = 2,
+    SWEETEXP_METRIC_NOTIFICATIONS_DROPPED = 3
+};
+
+enum {
+    SWEETEXP_INGEST_EVENTS = 1,
+    SWEETEXP_INGEST_BIND = 2
+};
+
+typedef struct {
+    uint32_t magic;
+    uint16_t type;              // SWEETEXP_INGEST_*
+    uint16_t count;             // Records following, <= SWEETEXP_INGEST_MAX_RECORDS
+} sweetexp_ingest_frame;
+
+typedef struct {
+    uint16_t slot;
+    uint16_t reserved;
+    int32_t user_id;
+    int64_t delta;
+} sweetexp_ingest_event;
+
+typedef struct {
+    uint16_t slot;
+    char name[30];              // Metric name, NUL padded
+} sweetexp_ingest_bind;
+
+// ==================== NOTIF ENGINE DATABASE ====================
+// Tables in notif_engine.db shared by SweetEngine's SQLite sink (user_achievements),
+// NotifEngine.java (notifications) and the NotifEngine UI's views.
+// SWEETEXP_SQL_SCHEMA is the subset of db_SQL_JSON_USERACCOUNT_EXTENSIONS.sql those
+// writes need, in plain SQLite DDL (no inline indexes), so a fresh database works
+// before the extension is applied. Both statements bind parameters by number as listed.
+
+#define SWEETEXP_NOTIF_DB_PATH "/lumen-motonexus6/system/notif/notif_engine.db"
+
+#define SWEETEXP_SQL_SCHEMA \
+    "CREATE TABLE IF NOT EXISTS notification_types (" \
+    " type_id INTEGER PRIMARY KEY AUTOINCREMENT, type_name TEXT NOT NULL UNIQUE," \
+    " display_name TEXT NOT NULL, priority_range_min INTEGER DEFAULT 1," \
+    " priority_range_max INTEGER DEFAULT 5, color_code TEXT DEFAULT '#FFFFFF', icon_name TEXT DEFAULT 'bell');" \
+    "INSERT OR IGNORE INTO notification_types" \
+    " (type_name, display_name, priority_range_min, priority_range_max, color_code, icon_name) VALUES" \
+    " ('achievement', 'Achievement Unlocked', 4, 5, '#FFD700', 'trophy')," \
+    " ('random', 'Sweet Message', 1, 3, '#4CAF50', 'heart')," \
+    " ('system', 'System Update', 2, 4, '#2196F3', 'info')," \
+    " ('kernel', 'Kernel Event', 3, 5, '#FF5722', 'cpu')," \
+    " ('wayland', 'Graphics Event', 2, 4, '#9C27B0', 'screen');" \
+    "CREATE TABLE IF NOT EXISTS notifications (" \
+    " notif_id INTEGER PRIMARY KEY AUTOINCREMENT, user_id INTEGER NOT NULL, type_id INTEGER NOT NULL," \
+    " title TEXT NOT NULL, raw_json_payload JSON NOT NULL, content_extracted TEXT," \
+    " priority INTEGER NOT NULL DEFAULT 1 CHECK (priority >= 1 AND priority <= 5)," \
+    " is_read BOOLEAN DEFAULT 0, is_trashed BOOLEAN DEFAULT 0," \
+    " created_at DATETIME DEFAULT CURRENT_TIMESTAMP, read_at DATETIME);" \
+    "CREATE TABLE IF NOT EXISTS user_achievements (" \
+    " ach_id INTEGER PRIMARY KEY AUTOINCREMENT, user_id INTEGER NOT NULL, achievement_id TEXT NOT NULL," \
+    " achievement_name TEXT NOT NULL, description TEXT, progress INTEGER DEFAULT 0," \
+    " target_value INTEGER NOT NULL, unlocked BOOLEAN DEFAULT 0, unlocked_at DATETIME," \
+    " created_at DATETIME DEFAULT CURRENT_TIMESTAMP, UNIQUE(user_id, achievement_id));" \
+    "CREATE INDEX IF NOT EXISTS idx_notifications_user_time ON notifications(user_id, created_at DESC);" \
+    "CREATE INDEX IF NOT EXISTS idx_achievements_user_progress ON user_achievements(user_id, progress DESC);"
+
+// 1 user_id, 2 achievement_id, 3 name, 4 description, 5 progress, 6 target,
+// 7 unlocked, 8 unlock time (unix seconds, 0 = none)
+#define SWEETEXP_SQL_UPSERT_ACHIEVEMENT \
+    "INSERT INTO user_achievements (user_id, achievement_id, achievement_name, description," \
+    " progress, target_value, unlocked, unlocked_at)" \
+    " VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, CASE WHEN ?8 > 0 THEN datetime(?8, 'unixepoch') END)" \
+    " ON CONFLICT(user_id, achievement_id) DO UPDATE SET achievement_name = excluded.achievement_name," \
+    " description = excluded.description, progress = excluded.progress, target_value = excluded.target_value," \
+    " unlocked = excluded.unlocked, unlocked_at = excluded.unlocked_at"
+
+// NotifEngine.java's insert, for SweetExpSqliteBench (the sink leaves this table to it):
+// 1 user_id, 2 type name (unknown types file as 'system'), 3 title, 4 JSON payload,
+// 5 message, 6 priority (1-5), 7 created (unix seconds)
+#define SWEETEXP_SQL_INSERT_NOTIFICATION \
+    "INSERT INTO notifications (user_id, type_id, title, raw_json_payload, content_extracted, priority, created_at)" \
+    " VALUES (?1, COALESCE((SELECT type_id FROM notification_types WHERE type_name = ?2)," \
+    " (SELECT type_id FROM notification_types WHERE type_name = 'system')), ?3, ?4, ?5, ?6," \
+    " datetime(?7, 'unixepoch'))"
+
+#endif // SWEETEXP_ABI_H
@@ -0,0 +1,38 @@
+/**
+ * sweetexp_catalog.h - Built-in SweetEngine achievements
+ * The single declaration of every built-in achievement. SweetExperiencesEngine.c
+ * expands it into a read-only catalogue; SweetExpCatalogGen.c expands it to
+ * generate the perfect hash in sweetexp_catalog_hash.h. After editing the list,
+ * rebuild and run sweetexp_cataloggen > sweetexp_catalog_hash.h.
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ */
+
+#ifndef SWEETEXP_CATALOG_H
+#define SWEETEXP_CATALOG_H
+
+#include <stdint.h>
+
+// X(id, name, description, target, metric, kind) - metric is a SWEETEXP_METRIC_*
+// suffix, kind an ACHIEVEMENT_* suffix (TOTAL, DAILY_STREAK, ACTIVE_DAYS_30, ...)
+#define SWEETEXP_BUILTIN_ACHIEVEMENTS(X) \
+    X(boot_master, "Boot Master", "Boot 10 times successfully", 10, BOOT_COUNT, TOTAL) \
+    X(wayland_pro, "Wayland Pro", "Process 500 Wayland events", 500, WAYLAND_EVENTS, TOTAL) \
+    X(daily_regular, "Daily Regular", "Use Lumen 7 days in a row", 7, WAYLAND_EVENTS, DAILY_STREAK)
+
+// Seeded FNV-1a with a murmur3 finalizer; seed 0 picks the bucket, the bucket's
+// displacement picks the slot
+static inline uint32_t sweetexp_catalog_hash(const char* key, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    while (*key) {
+        h ^= (uint8_t)*key++;
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+#endif // SWEETEXP_CATALOG_H
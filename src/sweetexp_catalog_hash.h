@@ -0,0 +1,12 @@
+// Generated by SweetExpCatalogGen.c from sweetexp_catalog.h - do not edit
+#ifndef SWEETEXP_CATALOG_HASH_H
+#define SWEETEXP_CATALOG_HASH_H
+
+#define SWEETEXP_CATALOG_HASH_COUNT 3
+
+static const uint16_t sweetexp_catalog_displace[SWEETEXP_CATALOG_HASH_COUNT] = {0, 1, 1};
+
+// Slot -> catalogue index
+static const uint8_t sweetexp_catalog_slot[SWEETEXP_CATALOG_HASH_COUNT] = {0, 1, 2};
+
+#endif // SWEETEXP_CATALOG_HASH_H
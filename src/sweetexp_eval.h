@@ -0,0 +1,142 @@
+/**
+ * sweetexp_eval.h - Batch achievement evaluation kernels
+ * Compares a contiguous array of progress values against an array of targets
+ * and produces a bitmask of entries that reached their target and were not
+ * already unlocked. Scalar, SSE4.2, AVX2 and NEON versions compute identical
+ * masks; sweetexp_eval_select() picks the best one the CPU supports.
+ * Shared by SweetExperiencesEngine.c and SweetExpEvalBench.c.
+ * Target: /lumen-motonexus6/fw/boot/main/k/sweetexp/
+ */
+
+#ifndef SWEETEXP_EVAL_H
+#define SWEETEXP_EVAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SWEETEXP_EVAL_X86 1
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(__arm__))
+#include <arm_neon.h>
+#define SWEETEXP_EVAL_NEON 1
+#endif
+
+// newly[w] bit j is set when values[i] >= targets[i] and unlocked[w] bit j is
+// clear, for i = 64 * w + j < n. Bits past n are zero.
+typedef void (*sweetexp_unlock_mask_fn)(const int64_t* values, const int64_t* targets,
+                                        const uint64_t* unlocked, uint64_t* newly, size_t n);
+
+static inline uint64_t sweetexp_ge_bits_scalar(const int64_t* values, const int64_t* targets, size_t count) {
+    uint64_t bits = 0;
+    for (size_t j = 0; j < count; j++) bits |= (uint64_t)(values[j] >= targets[j]) << j;
+    return bits;
+}
+
+static void sweetexp_unlock_mask_scalar(const int64_t* values, const int64_t* targets,
+                                        const uint64_t* unlocked, uint64_t* newly, size_t n) {
+    for (size_t w = 0; w * 64 < n; w++) {
+        size_t count = n - w * 64 < 64 ? n - w * 64 : 64;
+        newly[w] = sweetexp_ge_bits_scalar(values + w * 64, targets + w * 64, count) & ~unlocked[w];
+    }
+}
+
+#ifdef SWEETEXP_EVAL_X86
+__attribute__((target("sse4.2")))
+static void sweetexp_unlock_mask_sse42(const int64_t* values, const int64_t* targets,
+                                       const uint64_t* unlocked, uint64_t* newly, size_t n) {
+    for (size_t w = 0; w * 64 < n; w++) {
+        const int64_t* v = values + w * 64;
+        const int64_t* t = targets + w * 64;
+        size_t count = n - w * 64 < 64 ? n - w * 64 : 64;
+        uint64_t bits = 0;
+        size_t j = 0;
+        for (; j + 2 <= count; j += 2) {
+            __m128i lt = _mm_cmpgt_epi64(_mm_loadu_si128((const __m128i*)(t + j)),
+                                         _mm_loadu_si128((const __m128i*)(v + j)));
+            bits |= (uint64_t)(~_mm_movemask_pd(_mm_castsi128_pd(lt)) & 0x3) << j;
+        }
+        if (j < count) bits |= sweetexp_ge_bits_scalar(v + j, t + j, count - j) << j;  // j == 64 would overflow the shift
+        newly[w] = bits & ~unlocked[w];
+    }
+}
+
+__attribute__((target("avx2")))
+static void sweetexp_unlock_mask_avx2(const int64_t* values, const int64_t* targets,
+                                      const uint64_t* unlocked, uint64_t* newly, size_t n) {
+    for (size_t w = 0; w * 64 < n; w++) {
+        const int64_t* v = values + w * 64;
+        const int64_t* t = targets + w * 64;
+        size_t count = n - w * 64 < 64 ? n - w * 64 : 64;
+        uint64_t bits = 0;
+        size_t j = 0;
+        for (; j + 8 <= count; j += 8) {
+            __m256i lt0 = _mm256_cmpgt_epi64(_mm256_loadu_si256((const __m256i*)(t + j)),
+                                             _mm256_loadu_si256((const __m256i*)(v + j)));
+            __m256i lt1 = _mm256_cmpgt_epi64(_mm256_loadu_si256((const __m256i*)(t + j + 4)),
+                                             _mm256_loadu_si256((const __m256i*)(v + j + 4)));
+            uint32_t lt = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(lt0)) |
+                          (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(lt1)) << 4;
+            bits |= (uint64_t)(~lt & 0xFF) << j;
+        }
+        if (j < count) bits |= sweetexp_ge_bits_scalar(v + j, t + j, count - j) << j;
+        newly[w] = bits & ~unlocked[w];
+    }
+}
+#endif
+
+#ifdef SWEETEXP_EVAL_NEON
+// 1 in each lane where v >= t, else 0. AArch32 NEON has no 64-bit compare, so
+// there the sign of the saturating difference decides.
+static inline uint64x2_t sweetexp_ge_lanes_neon(int64x2_t v, int64x2_t t) {
+#ifdef __aarch64__
+    return vshrq_n_u64(vcgeq_s64(v, t), 63);
+#else
+    uint64x2_t lt = vshrq_n_u64(vreinterpretq_u64_s64(vqsubq_s64(v, t)), 63);
+    return veorq_u64(lt, vdupq_n_u64(1));
+#endif
+}
+
+static void sweetexp_unlock_mask_neon(const int64_t* values, const int64_t* targets,
+                                      const uint64_t* unlocked, uint64_t* newly, size_t n) {
+    for (size_t w = 0; w * 64 < n; w++) {
+        const int64_t* v = values + w * 64;
+        const int64_t* t = targets + w * 64;
+        size_t count = n - w * 64 < 64 ? n - w * 64 : 64;
+        uint64_t bits = 0;
+        size_t j = 0;
+        for (; j + 4 <= count; j += 4) {
+            uint64x2_t ge0 = sweetexp_ge_lanes_neon(vld1q_s64(v + j), vld1q_s64(t + j));
+            uint64x2_t ge1 = sweetexp_ge_lanes_neon(vld1q_s64(v + j + 2), vld1q_s64(t + j + 2));
+            uint64_t b = vgetq_lane_u64(ge0, 0) | vgetq_lane_u64(ge0, 1) << 1 |
+                         vgetq_lane_u64(ge1, 0) << 2 | vgetq_lane_u64(ge1, 1) << 3;
+            bits |= b << j;
+        }
+        if (j < count) bits |= sweetexp_ge_bits_scalar(v + j, t + j, count - j) << j;
+        newly[w] = bits & ~unlocked[w];
+    }
+}
+#endif
+
+// Best kernel for this CPU; `name` (optional) receives its label
+static inline sweetexp_unlock_mask_fn sweetexp_eval_select(const char** name) {
+    const char* label = "scalar";
+    sweetexp_unlock_mask_fn fn = sweetexp_unlock_mask_scalar;
+#if defined(SWEETEXP_EVAL_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        label = "avx2";
+        fn = sweetexp_unlock_mask_avx2;
+    } else if (__builtin_cpu_supports("sse4.2")) {
+        label = "sse4.2";
+        fn = sweetexp_unlock_mask_sse42;
+    }
+#elif defined(SWEETEXP_EVAL_NEON)
+    label = "neon";
+    fn = sweetexp_unlock_mask_neon;
+#endif
+    if (name) *name = label;
+    return fn;
+}
+
+#endif // SWEETEXP_EVAL_H